@@ -0,0 +1,127 @@
+// Микробенчмарк расчета границ графика: прежние три прохода par_unseq
+// (minmax частоты, transform в дБ, minmax дБ) против однопроходного BoundsKernel.
+//
+// BoundsBenchmark [maxPoints]   (по умолчанию 100'000'000)
+
+#include "BoundsKernel.h"
+#include "Measurement.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <execution>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Result {
+    double minFreq, maxFreq, minMag, maxMag;
+};
+
+// Реализация calculateBounds до перехода на BoundsKernel
+Result threePassBounds(const std::vector<FrequencyPoint>& data) {
+    auto freqRange = std::minmax_element(
+        std::execution::par_unseq,
+        data.begin(), data.end(),
+        [](const auto& a, const auto& b) { return a.frequency < b.frequency; }
+    );
+    
+    std::vector<double> magnitudes(data.size());
+    std::transform(
+        std::execution::par_unseq,
+        data.begin(), data.end(),
+        magnitudes.begin(),
+        [](const auto& point) { return 20.0 * std::log10(std::abs(point.s11)); }
+    );
+    
+    auto magRange = std::minmax_element(
+        std::execution::par_unseq,
+        magnitudes.begin(), magnitudes.end()
+    );
+    
+    return {freqRange.first->frequency, freqRange.second->frequency, *magRange.first, *magRange.second};
+}
+
+Result fusedBounds(const std::vector<double>& freq, const std::vector<double>& re, const std::vector<double>& im) {
+    const auto extents = freq.size() > 256 * 1024
+        ? BoundsKernel::computeParallel(freq, re, im)
+        : BoundsKernel::compute(freq, re, im);
+    return {extents.minFreq, extents.maxFreq, extents.minMagDb(), extents.maxMagDb()};
+}
+
+// Медиана времени одного вызова, нс
+template<typename Fn>
+double measure(Fn&& fn, size_t points) {
+    using Clock = std::chrono::steady_clock;
+    const size_t repetitions = std::clamp<size_t>(200'000'000 / std::max<size_t>(points, 1), 3, 1000);
+    
+    std::vector<double> samples;
+    samples.reserve(repetitions);
+    volatile double sink = 0.0;
+    for (size_t i = 0; i < repetitions; ++i) {
+        const auto start = Clock::now();
+        const Result result = fn();
+        const auto stop = Clock::now();
+        sink = sink + result.maxMag;
+        samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+    
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+void generate(size_t points, std::vector<double>& freq, std::vector<double>& re, std::vector<double>& im) {
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> noise(-0.01, 0.01);
+    freq.resize(points);
+    re.resize(points);
+    im.resize(points);
+    for (size_t i = 0; i < points; ++i) {
+        const double phase = static_cast<double>(i) * 1e-3;
+        const double magnitude = 0.5 + 0.45 * std::sin(phase * 0.1);
+        freq[i] = 1e9 + static_cast<double>(i) * 1e3;
+        re[i] = magnitude * std::cos(phase) + noise(rng);
+        im[i] = magnitude * std::sin(phase) + noise(rng);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t maxPoints = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000'000;
+    
+    std::printf("%12s %14s %14s %10s %12s\n", "points", "3-pass, us", "fused, us", "speedup", "fused Mpt/s");
+    
+    for (size_t points = 100; points <= maxPoints; points *= 10) {
+        std::vector<double> freq, re, im;
+        generate(points, freq, re, im);
+        
+        double threePassNs = 0.0;
+        Result reference{};
+        {
+            std::vector<FrequencyPoint> data(points);
+            for (size_t i = 0; i < points; ++i) {
+                data[i] = FrequencyPoint(freq[i], {re[i], im[i]});
+            }
+            reference = threePassBounds(data);
+            threePassNs = measure([&] { return threePassBounds(data); }, points);
+        }
+        
+        const Result fused = fusedBounds(freq, re, im);
+        const double fusedNs = measure([&] { return fusedBounds(freq, re, im); }, points);
+        
+        const double magError = std::max(std::abs(fused.minMag - reference.minMag), std::abs(fused.maxMag - reference.maxMag));
+        if (fused.minFreq != reference.minFreq || fused.maxFreq != reference.maxFreq || magError > 1e-9) {
+            std::fprintf(stderr, "mismatch at %zu points (mag error %g)\n", points, magError);
+            return 1;
+        }
+        
+        std::printf("%12zu %14.2f %14.2f %9.2fx %12.1f\n",
+                    points, threePassNs / 1e3, fusedNs / 1e3, threePassNs / fusedNs,
+                    static_cast<double>(points) / fusedNs * 1e3);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,321 @@
+// Бенчмарк горячих путей загрузки и отрисовки на синтетических .s1p:
+//   parse.serial / parse.parallel — S11Parser::parseFileExpected одним блоком и по блокам;
+//   bounds                        — GraphRenderer::calculateBounds полным проходом;
+//   lod.build                     — построение LOD-пирамиды;
+//   resample.linear / .cubic      — Resampler на сетку со сдвигом на полшага;
+//   render.overview / render.zoom — PlotPainter::renderFrame в QImage (весь диапазон
+//                                   по пирамиде и 1% диапазона по всем точкам), как у GraphWidget.
+// Результаты печатаются таблицей и пишутся в JSON для сравнения между коммитами.
+//
+// PipelineBenchmark [--min-points N] [--max-points N] [--styles compact,scientific,padded]
+//                   [--json FILE] [--dir DIR] [--label TEXT] [--min-time SECONDS] [--keep-files]
+
+#include "SyntheticTouchstone.h"
+#include "S11Parser.h"
+#include "Measurement.h"
+#include "LodPyramid.h"
+#include "Resampler.h"
+#include "GraphRenderer.h"
+#include "PlotPainter.h"
+#include <QGuiApplication>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace {
+
+struct Options {
+    size_t minPoints = 1'000;
+    size_t maxPoints = 100'000'000;
+    std::vector<SyntheticTouchstone::Style> styles{SyntheticTouchstone::allStyles.begin(),
+                                                   SyntheticTouchstone::allStyles.end()};
+    std::filesystem::path jsonPath = "pipeline-benchmark.json";
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "touchstone-bench";
+    std::string label;
+    double minTimeSeconds = 0.5;
+    bool keepFiles = false;
+};
+
+struct Result {
+    std::string name;
+    std::string style;
+    size_t points = 0;
+    size_t bytes = 0;
+    size_t repetitions = 0;
+    double medianNs = 0.0;
+    double minNs = 0.0;
+};
+
+constexpr QSize frameSize(1600, 900);
+
+// Повторы до minTime суммарно (не меньше одного), медиана и минимум одного вызова, нс.
+// fn возвращает false при ошибке — тогда замер прерывается
+template<typename Fn>
+bool measure(Fn&& fn, double minTimeSeconds, Result& result) {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t maxRepetitions = 1000;
+    
+    std::vector<double> samples;
+    double totalNs = 0.0;
+    while (samples.empty() || (totalNs < minTimeSeconds * 1e9 && samples.size() < maxRepetitions)) {
+        const auto start = Clock::now();
+        const bool ok = fn();
+        const auto stop = Clock::now();
+        if (!ok) {
+            return false;
+        }
+        samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+        totalNs += samples.back();
+    }
+    
+    result.repetitions = samples.size();
+    result.minNs = *std::min_element(samples.begin(), samples.end());
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    result.medianNs = samples[samples.size() / 2];
+    return true;
+}
+
+void printResult(const Result& result) {
+    const double seconds = result.medianNs / 1e9;
+    std::printf("%-16s %-11s %12zu %14.3f %12.1f %10.1f %6zu\n",
+                result.name.c_str(), result.style.empty() ? "-" : result.style.c_str(), result.points,
+                result.medianNs / 1e6, static_cast<double>(result.points) / seconds / 1e6,
+                result.bytes ? static_cast<double>(result.bytes) / seconds / (1024.0 * 1024.0) : 0.0,
+                result.repetitions);
+    std::fflush(stdout);
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+bool writeJson(const Options& options, const std::vector<Result>& results) {
+    std::FILE* file = std::fopen(options.jsonPath.string().c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    
+    const auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::fprintf(file, "{\n  \"benchmark\": \"PipelineBenchmark\",\n  \"label\": \"%s\",\n"
+                       "  \"timestamp\": %lld,\n  \"hardwareThreads\": %u,\n"
+                       "  \"frameWidth\": %d,\n  \"frameHeight\": %d,\n  \"results\": [",
+                 jsonEscape(options.label).c_str(), static_cast<long long>(timestamp),
+                 std::thread::hardware_concurrency(), frameSize.width(), frameSize.height());
+    
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        const double seconds = result.medianNs / 1e9;
+        std::fprintf(file, "%s\n    {\"name\": \"%s\", \"style\": \"%s\", \"points\": %zu, \"bytes\": %zu, "
+                           "\"repetitions\": %zu, \"medianNs\": %.0f, \"minNs\": %.0f, "
+                           "\"pointsPerSecond\": %.0f, \"megabytesPerSecond\": %.3f}",
+                     i ? "," : "", result.name.c_str(), result.style.c_str(), result.points, result.bytes,
+                     result.repetitions, result.medianNs, result.minNs,
+                     static_cast<double>(result.points) / seconds,
+                     static_cast<double>(result.bytes) / seconds / (1024.0 * 1024.0));
+    }
+    
+    std::fputs("\n  ]\n}\n", file);
+    return std::fclose(file) == 0;
+}
+
+bool parseArguments(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        
+        if (arg == "--keep-files") {
+            options.keepFiles = true;
+            continue;
+        }
+        if (!value) {
+            return false;
+        }
+        ++i;
+        
+        if (arg == "--min-points") {
+            options.minPoints = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+        } else if (arg == "--max-points") {
+            options.maxPoints = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--json") {
+            options.jsonPath = value;
+        } else if (arg == "--dir") {
+            options.directory = value;
+        } else if (arg == "--label") {
+            options.label = value;
+        } else if (arg == "--min-time") {
+            options.minTimeSeconds = std::strtod(value, nullptr);
+        } else if (arg == "--styles") {
+            options.styles.clear();
+            std::string_view list = value;
+            while (!list.empty()) {
+                const size_t comma = std::min(list.find(','), list.size());
+                const auto style = SyntheticTouchstone::styleFromName(list.substr(0, comma));
+                if (!style) {
+                    return false;
+                }
+                options.styles.push_back(*style);
+                list.remove_prefix(std::min(comma + 1, list.size()));
+            }
+        } else {
+            return false;
+        }
+    }
+    return !options.styles.empty();
+}
+
+bool benchmarkParse(const Options& options, size_t points, SyntheticTouchstone::Style style,
+                    std::vector<Result>& results) {
+    const std::string styleName(SyntheticTouchstone::styleName(style));
+    const auto filePath = options.directory / ("synthetic-" + std::to_string(points) + "-" + styleName + ".s1p");
+    
+    // Содержимое детерминировано: уже записанный файл можно брать повторно
+    std::error_code error;
+    if (!std::filesystem::exists(filePath, error) && !SyntheticTouchstone::write(filePath, points, style)) {
+        std::fprintf(stderr, "cannot write %s\n", filePath.string().c_str());
+        return false;
+    }
+    const size_t bytes = static_cast<size_t>(std::filesystem::file_size(filePath, error));
+    
+    const auto run = [&](const char* name, size_t parallelThreshold) {
+        S11Parser::ParseOptions parseOptions;
+        parseOptions.parallelThreshold = parallelThreshold;
+        
+        Result result{name, styleName, points, bytes};
+        const bool ok = measure([&] {
+            const auto parsed = S11Parser::parseFileExpected(filePath, nullptr, parseOptions);
+            const auto* measurement = std::get_if<Measurement>(&parsed);
+            return measurement && measurement->size() == points;
+        }, options.minTimeSeconds, result);
+        if (!ok) {
+            std::fprintf(stderr, "%s failed on %s\n", name, filePath.string().c_str());
+            return false;
+        }
+        printResult(result);
+        results.push_back(std::move(result));
+        return true;
+    };
+    
+    const bool ok = run("parse.serial", std::numeric_limits<size_t>::max()) && run("parse.parallel", 0);
+    if (!options.keepFiles) {
+        std::filesystem::remove(filePath, error);
+    }
+    return ok;
+}
+
+void benchmarkBoundsAndRender(const Options& options, size_t points, std::vector<Result>& results) {
+    auto columns = SyntheticTouchstone::columns(points);
+    const Measurement measurement = Measurement::fromColumns(std::move(columns.frequency), std::move(columns.real),
+                                                             std::move(columns.imag));
+    
+    const auto record = [&](const char* name, auto&& fn, size_t bytes = 0) {
+        Result result{name, "", points, bytes};
+        measure([&] { fn(); return true; }, options.minTimeSeconds, result);
+        printResult(result);
+        results.push_back(std::move(result));
+    };
+    
+    volatile double sink = 0.0;
+    record("bounds", [&] { sink = sink + GraphRenderer::calculateBounds(measurement).maxMag; });
+    
+    // Сетка другого прибора: тот же шаг со сдвигом на полшага. МБ/с — по трем
+    // столбцам свипа, сетке и двум столбцам результата
+    const auto frequency = measurement.frequencies();
+    const double halfStep = points > 1 ? (frequency[1] - frequency[0]) / 2.0 : 0.0;
+    std::vector<double> grid(points);
+    std::transform(frequency.begin(), frequency.end(), grid.begin(), [halfStep](double f) { return f + halfStep; });
+    std::vector<double> real(points);
+    std::vector<double> imag(points);
+    const size_t resampleBytes = points * 6 * sizeof(double);
+    Resampler::Options resample;
+    resample.extrapolation = Resampler::Extrapolation::Hold;
+    record("resample.linear", [&] {
+        Resampler::resample(frequency, measurement.realParts(), measurement.imagParts(), grid, real, imag, resample);
+    }, resampleBytes);
+    resample.method = Resampler::Method::Cubic;
+    record("resample.cubic", [&] {
+        Resampler::resample(frequency, measurement.realParts(), measurement.imagParts(), grid, real, imag, resample);
+    }, resampleBytes);
+    
+    LodPyramid lod;
+    record("lod.build", [&] { lod = LodPyramid::build(measurement.frequencies(), measurement.logMagnitudes()); });
+    
+    // Как в GraphWidget: обзор по пирамиде, при зуме — все точки окна
+    const auto bounds = GraphRenderer::calculateBounds(measurement, lod);
+    record("render.overview", [&] {
+        sink = sink + PlotPainter::renderFrame(measurement, lod, bounds, false, frameSize, 1.0).width();
+    });
+    
+    GraphRenderer::ZoomParams zoom;
+    zoom.freqMin = bounds.minFreq + (bounds.maxFreq - bounds.minFreq) * 0.495;
+    zoom.freqMax = bounds.minFreq + (bounds.maxFreq - bounds.minFreq) * 0.505;
+    zoom.magMin = bounds.minMag;
+    zoom.magMax = bounds.maxMag;
+    zoom.isActive = true;
+    const auto zoomBounds = GraphRenderer::applyZoom(bounds, zoom);
+    record("render.zoom", [&] {
+        sink = sink + PlotPainter::renderFrame(measurement, lod, zoomBounds, true, frameSize, 1.0).width();
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--min-points N] [--max-points N] [--styles compact,scientific,padded]\n"
+                             "       [--json FILE] [--dir DIR] [--label TEXT] [--min-time SECONDS] [--keep-files]\n",
+                     argv[0]);
+        return 2;
+    }
+    
+    // Шрифтам подписей нужен QGuiApplication; окна не создаются
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    
+    std::printf("%-16s %-11s %12s %14s %12s %10s %6s\n",
+                "benchmark", "style", "points", "median, ms", "Mpt/s", "MB/s", "reps");
+    
+    std::vector<Result> results;
+    for (size_t points = options.minPoints; points <= options.maxPoints; points *= 10) {
+        for (const auto style : options.styles) {
+            if (!benchmarkParse(options, points, style, results)) {
+                return 1;
+            }
+        }
+        benchmarkBoundsAndRender(options, points, results);
+        
+        if (points > std::numeric_limits<size_t>::max() / 10) {
+            break;
+        }
+    }
+    
+    if (!writeJson(options, results)) {
+        std::fprintf(stderr, "cannot write %s\n", options.jsonPath.string().c_str());
+        return 1;
+    }
+    std::printf("results: %s\n", options.jsonPath.string().c_str());
+    return 0;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+// Детерминированные синтетические .s1p для бенчмарков: одна и та же кривая
+// при любом числе точек, байт в байт одинаковые файлы на всех платформах
+// (шум берется из сырых чисел mt19937_64, без std::*_distribution).
+//
+// Стили оформления нагружают разные ветки парсера:
+//   compact    — "f re im", одиночные пробелы, фиксированная точка, LF;
+//   scientific — экспоненциальная запись через табуляцию, CRLF;
+//   padded     — отступы, несколько пробелов между полями и в конце строки,
+//                кратчайшая запись чисел, комментарии и пустые строки внутри данных.
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <vector>
+
+class SyntheticTouchstone {
+public:
+    enum class Style {
+        Compact,
+        Scientific,
+        Padded
+    };
+    
+    static constexpr std::array<Style, 3> allStyles{Style::Compact, Style::Scientific, Style::Padded};
+    
+    struct Columns {
+        std::vector<double> frequency;
+        std::vector<double> real;
+        std::vector<double> imag;
+    };
+    
+    [[nodiscard]] static std::string_view styleName(Style style) noexcept {
+        switch (style) {
+            case Style::Compact: return "compact";
+            case Style::Scientific: return "scientific";
+            case Style::Padded: return "padded";
+        }
+        return "";
+    }
+    
+    [[nodiscard]] static std::optional<Style> styleFromName(std::string_view name) noexcept {
+        for (Style style : allStyles) {
+            if (styleName(style) == name) {
+                return style;
+            }
+        }
+        return std::nullopt;
+    }
+    
+    // Те же точки, что записываются в файл, сразу по столбцам
+    [[nodiscard]] static Columns columns(size_t points) {
+        Columns result;
+        result.frequency.resize(points);
+        result.real.resize(points);
+        result.imag.resize(points);
+        
+        Generator generator;
+        for (size_t i = 0; i < points; ++i) {
+            generator.next(i, result.frequency[i], result.real[i], result.imag[i]);
+        }
+        return result;
+    }
+    
+    // Файл с заголовком "# Hz S RI R 50"; false при ошибке записи
+    static bool write(const std::filesystem::path& filePath, size_t points, Style style) {
+        std::FILE* file = std::fopen(filePath.string().c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        
+        const std::string_view newline = style == Style::Scientific ? "\r\n" : "\n";
+        std::vector<char> buffer;
+        buffer.reserve(writeBufferBytes + 256);
+        
+        const auto append = [&buffer](std::string_view text) {
+            buffer.insert(buffer.end(), text.begin(), text.end());
+        };
+        const auto appendNumber = [&buffer](double value, std::chars_format format, int precision) {
+            char digits[64];
+            const auto [end, ec] = precision < 0 ? std::to_chars(digits, digits + sizeof(digits), value)
+                                                 : std::to_chars(digits, digits + sizeof(digits), value, format, precision);
+            buffer.insert(buffer.end(), digits, ec == std::errc{} ? end : digits);
+        };
+        
+        append("! Synthetic S11 sweep for benchmarks");
+        append(newline);
+        append("! points: ");
+        appendNumber(static_cast<double>(points), std::chars_format::fixed, 0);
+        append(", style: ");
+        append(styleName(style));
+        append(newline);
+        append(style == Style::Padded ? "  #   Hz  S  RI  R  50  " : "# Hz S RI R 50");
+        append(newline);
+        
+        Generator generator;
+        bool ok = true;
+        for (size_t i = 0; i < points && ok; ++i) {
+            double frequency, re, im;
+            generator.next(i, frequency, re, im);
+            
+            switch (style) {
+                case Style::Compact:
+                    appendNumber(frequency, std::chars_format::fixed, 0);
+                    append(" ");
+                    appendNumber(re, std::chars_format::fixed, 6);
+                    append(" ");
+                    appendNumber(im, std::chars_format::fixed, 6);
+                    break;
+                case Style::Scientific:
+                    appendNumber(frequency, std::chars_format::scientific, 9);
+                    append("\t");
+                    appendNumber(re, std::chars_format::scientific, 9);
+                    append("\t");
+                    appendNumber(im, std::chars_format::scientific, 9);
+                    break;
+                case Style::Padded:
+                    if (i % 4096 == 0 && i > 0) {
+                        append("! segment marker");
+                        append(newline);
+                        append(newline);
+                    }
+                    append("   ");
+                    appendNumber(frequency, std::chars_format::general, -1);
+                    append("    ");
+                    appendNumber(re, std::chars_format::general, -1);
+                    append(i % 2 ? " \t " : "  ");
+                    appendNumber(im, std::chars_format::general, -1);
+                    append("   ");
+                    break;
+            }
+            append(newline);
+            
+            if (buffer.size() >= writeBufferBytes) {
+                ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+                buffer.clear();
+            }
+        }
+        
+        ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        return std::fclose(file) == 0 && ok;
+    }
+    
+private:
+    static constexpr size_t writeBufferBytes = 1024 * 1024;
+    
+    // Кривая из BoundsBenchmark: медленная огибающая |S11| с вращением фазы и шумом ±0.01
+    class Generator {
+    public:
+        void next(size_t index, double& frequency, double& re, double& im) {
+            const double phase = static_cast<double>(index) * 1e-3;
+            const double magnitude = 0.5 + 0.45 * std::sin(phase * 0.1);
+            frequency = 1e9 + static_cast<double>(index) * 1e3;
+            re = magnitude * std::cos(phase) + noise();
+            im = magnitude * std::sin(phase) + noise();
+        }
+        
+    private:
+        double noise() {
+            // 53 старших бита -> [0, 1) -> [-0.01, 0.01)
+            return (static_cast<double>(m_rng() >> 11) * 0x1.0p-53 - 0.5) * 0.02;
+        }
+        
+        std::mt19937_64 m_rng{42};
+    };
+};
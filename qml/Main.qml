@@ -30,7 +30,7 @@ ApplicationWindow {
                     }
                 }
                 
-                if (hasValidFile && !backend.isLoading) {
+                if (hasValidFile) {
                     drag.accept(Qt.CopyAction);
                     dropOverlay.visible = true;
                 } else {
@@ -48,16 +48,21 @@ ApplicationWindow {
         onDropped: function(drop) {
             dropOverlay.visible = false;
             
-            if (drop.hasUrls && !backend.isLoading) {
+            // Все .s1p из перетаскивания: первый — основная трасса, остальные поверх
+            var urls = [];
+            if (drop.hasUrls) {
                 for (var i = 0; i < drop.urls.length; i++) {
                     var url = drop.urls[i].toString();
-                    if (url.toLowerCase().endsWith('.s1p') || url.toLowerCase().endsWith('.S1P')) {
-                        backend.loadFile(drop.urls[i]);
-                        drop.accept(Qt.CopyAction);
-                        return;
+                    if (url.toLowerCase().endsWith('.s1p')) {
+                        urls.push(drop.urls[i]);
                     }
                 }
             }
+            if (urls.length > 0) {
+                backend.loadFiles(urls);
+                drop.accept(Qt.CopyAction);
+                return;
+            }
             drop.accepted = false;
         }
     }
@@ -74,14 +79,37 @@ ApplicationWindow {
 
             Button {
                 text: "📁 Load Touchstone File"
-                enabled: !backend.isLoading
                 onClicked: fileDialog.open()
                 
                 ToolTip.visible: hovered
-                ToolTip.text: "Load .s1p file or drag & drop it anywhere"
+                ToolTip.text: "Load .s1p files or drag & drop them anywhere; extra files are overlaid on the first"
+                ToolTip.delay: 500
+            }
+
+            Button {
+                text: "📊 Envelope"
+                onClicked: envelopeDialog.open()
+                
+                ToolTip.visible: hovered
+                ToolTip.text: "Mean, ±σ and min/max of |S11| across many sweeps, drawn under the traces"
+                ToolTip.delay: 500
+            }
+
+            Button {
+                text: "🎯 Mask"
+                onClicked: maskDialog.open()
+                
+                ToolTip.visible: hovered
+                ToolTip.text: "Load a limit-line mask (lines like: upper 2.4e9 2.5e9 -15) and check the trace against it"
                 ToolTip.delay: 500
             }
 
+            Button {
+                text: "Clear Mask"
+                visible: backend.hasMask
+                onClicked: backend.clearMask()
+            }
+
             Button {
                 text: "Clear"
                 enabled: backend.hasData && !backend.isLoading
@@ -94,6 +122,35 @@ ApplicationWindow {
                 onClicked: backend.resetZoom()
             }
 
+            CheckBox {
+                text: "Auto-scale Y"
+                checked: backend.autoScaleY
+                onToggled: backend.autoScaleY = checked
+                
+                ToolTip.visible: hovered
+                ToolTip.text: "Fit the |S11| axis to the data inside the zoomed frequency range"
+                ToolTip.delay: 500
+            }
+
+            CheckBox {
+                text: "Follow file"
+                checked: backend.following
+                onToggled: backend.following = checked
+                
+                ToolTip.visible: hovered
+                ToolTip.text: "Watch the loaded file: appended lines are added to the trace, a rewritten file is reloaded"
+                ToolTip.delay: 500
+            }
+
+            CheckBox {
+                id: perfHudToggle
+                text: "Perf HUD"
+                
+                ToolTip.visible: hovered
+                ToolTip.text: "Show load, memory and frame timings over the graph"
+                ToolTip.delay: 500
+            }
+
             BusyIndicator {
                 running: backend.isLoading
                 visible: backend.isLoading
@@ -101,6 +158,20 @@ ApplicationWindow {
                 implicitHeight: 24
             }
 
+            ProgressBar {
+                visible: backend.isLoading
+                from: 0
+                to: 1
+                value: backend.loadProgress
+                implicitWidth: 120
+            }
+
+            Button {
+                text: "Cancel"
+                visible: backend.isLoading || backend.pendingTraceLoads > 0 || backend.pendingEnvelopeLoads > 0
+                onClicked: backend.cancelLoad()
+            }
+
             Item {
                 Layout.fillWidth: true
             }
@@ -150,6 +221,9 @@ ApplicationWindow {
                 anchors.fill: parent
                 anchors.margins: 1
                 
+                // Замеры кадров идут, только пока HUD на экране
+                metricsEnabled: perfHudToggle.checked
+                
                 loadingText: "Loading graph..."
                 emptyText: "Load a Touchstone file to display S11 graph\n\nDrag & drop .s1p files here or click 'Load Touchstone File'"
                 
@@ -188,8 +262,8 @@ ApplicationWindow {
                             var x2 = graphWidget.selectionEnd.x;
                             var y2 = graphWidget.selectionEnd.y;
 
-                            // Зум если выделена достаточно большая область
-                            if (Math.abs(x2 - x1) > 20 && Math.abs(y2 - y1) > 20) {
+                            // Зум если выделена достаточно большая область (при автомасштабе Y важна только ширина)
+                            if (Math.abs(x2 - x1) > 20 && (backend.autoScaleY || Math.abs(y2 - y1) > 20)) {
                                 backend.zoomToPixelRegion(x1, y1, x2, y2, graphWidget.width, graphWidget.height);
                             }
                         }
@@ -217,6 +291,52 @@ ApplicationWindow {
                     font.pointSize: 10
                     visible: graphWidget.hasData && !graphWidget.isLoading
                 }
+
+                // Performance HUD: скрытый не создается и не держит привязок
+                Loader {
+                    anchors.top: parent.top
+                    anchors.right: parent.right
+                    anchors.margins: 10
+                    active: perfHudToggle.checked
+
+                    sourceComponent: Rectangle {
+                        width: hudColumn.implicitWidth + 16
+                        height: hudColumn.implicitHeight + 12
+                        color: "#cc263238"
+                        radius: 4
+
+                        Column {
+                            id: hudColumn
+                            anchors.centerIn: parent
+                            spacing: 2
+
+                            Text {
+                                text: "Load: " + backend.lastParseMs.toFixed(1) + " ms, "
+                                      + backend.parseThroughputMBps.toFixed(1) + " MB/s"
+                                color: "white"
+                                font.family: "monospace"
+                                font.pointSize: 9
+                            }
+
+                            Text {
+                                text: "Resident: " + backend.residentPoints + " points, "
+                                      + (backend.residentBytes / (1024 * 1024)).toFixed(1) + " MB"
+                                color: "white"
+                                font.family: "monospace"
+                                font.pointSize: 9
+                            }
+
+                            Text {
+                                text: "Frame: last " + graphWidget.lastPaintMs.toFixed(2)
+                                      + " / p50 " + graphWidget.paintP50Ms.toFixed(2)
+                                      + " / p99 " + graphWidget.paintP99Ms.toFixed(2) + " ms"
+                                color: "white"
+                                font.family: "monospace"
+                                font.pointSize: 9
+                            }
+                        }
+                    }
+                }
             }
         }
 
@@ -242,9 +362,32 @@ ApplicationWindow {
                 }
 
                 Text {
-                    text: backend.hasData ? "Data loaded" : ""
+                    text: backend.pendingTraceLoads > 0
+                          ? backend.traceCount + " traces, " + backend.pendingTraceLoads + " loading"
+                          : backend.traceCount > 1 ? backend.traceCount + " traces" : "Data loaded"
                     color: "#666"
-                    visible: backend.hasData
+                    visible: backend.hasData || backend.pendingTraceLoads > 0
+                }
+
+                Text {
+                    text: backend.pendingEnvelopeLoads > 0
+                          ? "Envelope: " + backend.envelopeSweeps + " sweeps, " + backend.pendingEnvelopeLoads + " loading"
+                          : "Envelope: " + backend.envelopeSweeps + " sweeps"
+                    color: "#008080"
+                    visible: backend.envelopeSweeps > 0 || backend.pendingEnvelopeLoads > 0
+                }
+
+                Text {
+                    text: backend.maskStatus
+                    color: backend.maskPassed ? "green" : backend.maskFailed ? "red" : "#666"
+                    font.bold: backend.maskPassed || backend.maskFailed
+                    visible: backend.hasMask
+                }
+
+                Text {
+                    text: backend.followStatus
+                    color: "#1565c0"
+                    visible: backend.following
                 }
             }
         }
@@ -325,12 +468,32 @@ ApplicationWindow {
 
     FileDialog {
         id: fileDialog
-        title: "Select Touchstone File"
+        title: "Select Touchstone Files"
+        fileMode: FileDialog.OpenFiles
         nameFilters: ["Touchstone files (*.s1p *.S1P)", "All files (*)"]
         onAccepted: {
-            if (fileDialog.currentFile !== undefined) {
-                backend.loadFile(fileDialog.currentFile);
+            if (fileDialog.selectedFiles.length > 0) {
+                backend.loadFiles(fileDialog.selectedFiles);
             }
         }
     }
+
+    FileDialog {
+        id: envelopeDialog
+        title: "Select Sweeps for Envelope"
+        fileMode: FileDialog.OpenFiles
+        nameFilters: ["Touchstone files (*.s1p *.S1P)", "All files (*)"]
+        onAccepted: {
+            if (envelopeDialog.selectedFiles.length > 0) {
+                backend.loadEnvelope(envelopeDialog.selectedFiles);
+            }
+        }
+    }
+
+    FileDialog {
+        id: maskDialog
+        title: "Select Limit Mask"
+        nameFilters: ["Mask files (*.mask *.txt)", "All files (*)"]
+        onAccepted: backend.loadMask(maskDialog.selectedFile)
+    }
 }
@@ -1,97 +1,1205 @@
 #include "Backend.h"
 #include "GraphWidget.h"
+#include "PlotPainter.h"
+#include "OutOfCoreSweep.h"
+#include "PerformanceUtils.h"
 #include <QUrl>
+#include <QFileInfo>
 #include <QFutureWatcher>
+#include <QStandardPaths>
+#include <QDir>
 #include <qDebug>
+#include <algorithm>
+#include <chrono>
+#include <execution>
+#include <functional>
+#include <utility>
+#include <limits>
 #include <tuple>
 
-static std::tuple<S11Parser::ParseResult, Measurement, QString> parseFileAsync(const QString& filePath) {
-    Measurement measurement;
-    S11Parser::ParseResult result = S11Parser::parseFile(filePath.toStdString(), measurement);
+using ParseOutput = std::tuple<S11Parser::ParseResult, MeasurementSnapshot::Ptr, QString>;
+// Свернут ли файл в огибающую и текст ошибки, если нет
+using EnvelopeOutput = std::pair<bool, QString>;
+// nullptr — точки под маской не удалось прочитать
+using MaskOutput = LimitMask::ResultPtr;
+using PreviewCallback = std::function<void(MeasurementSnapshot::Ptr)>;
+
+namespace {
+
+// Пирамида, которая растет вместе с потоковым разбором, и предпросмотры из нее.
+// Живет в рабочем потоке загрузки; каждая волна точек обрабатывается один раз
+class PreviewBuilder {
+public:
+    explicit PreviewBuilder(PreviewCallback publish) : m_publish(std::move(publish)) {}
+    
+    void append(std::span<const double> frequency, std::span<const double> real, std::span<const double> imag) {
+        if (!m_sorted || frequency.empty()) {
+            return;
+        }
+        
+        // Неотсортированный файл парсер отсортирует в конце; предпросмотр для него не строится
+        if (frequency.front() < m_lastFrequency || !std::is_sorted(frequency.begin(), frequency.end())) {
+            m_sorted = false;
+            m_lod = LodPyramid();
+            return;
+        }
+        m_lastFrequency = frequency.back();
+        
+        m_magnitudes.resize(frequency.size());
+        std::transform(
+            std::execution::par_unseq,
+            real.begin(), real.end(),
+            imag.begin(),
+            m_magnitudes.begin(),
+            [](double re, double im) { return logMagnitudeDb(re, im); }
+        );
+        m_lod.append(frequency, m_magnitudes);
+        
+        // Не чаще частоты кадров; снимок несет только огрубленную пирамиду.
+        // Без получателя (наложенные трассы) пирамида только растет для итогового снимка
+        const auto now = Clock::now();
+        if (m_publish && now - m_lastPublish >= previewInterval) {
+            m_lastPublish = now;
+            PERF_MEASURE("PreviewBuilder::publish");
+            m_publish(MeasurementSnapshot::createPreview(m_lod.coarsened(previewBuckets)));
+        }
+    }
+    
+    [[nodiscard]] LodPyramid takePyramid() {
+        return m_sorted ? std::move(m_lod) : LodPyramid();
+    }
+    
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto previewInterval = std::chrono::milliseconds(16);
+    static constexpr size_t previewBuckets = 16 * 1024;
     
-    QString errorMessage;
+    PreviewCallback m_publish;
+    LodPyramid m_lod;
+    std::vector<double> m_magnitudes;
+    double m_lastFrequency = -std::numeric_limits<double>::infinity();
+    bool m_sorted = true;
+    Clock::time_point m_lastPublish{};
+};
+
+// Сколько наложенных файлов читается одновременно и нижняя граница их доли лимита памяти
+constexpr int maxConcurrentTraceLoads = 4;
+constexpr size_t minTraceMemoryLimit = 16ull * 1024 * 1024;
+// Огибающая перестраивается за O(сетки), поэтому во время загрузки публикуется не на каждый файл
+constexpr qint64 envelopePublishIntervalMs = 100;
+// Слежение за файлом: пауза после последнего события, предел задержки при непрерывной
+// записи, ожидание незавершенной последней строки и периоды опроса без наблюдателя
+// и с ним (сетевые диски событий не присылают)
+constexpr int followDebounceMs = 100;
+constexpr qint64 followMaxDelayMs = 500;
+constexpr int followSettleMs = 1000;
+constexpr int followPollMs = 250;
+constexpr int followSafetyPollMs = 2000;
+
+} // namespace
+
+// Все, что нужно рабочему потоку для одной загрузки
+struct LoadRequest {
+    QString filePath;
+    S11Parser::ParseOptions options;
+    PreviewCallback publishPreview;
+    std::shared_ptr<SweepCache> cache;
+    QThreadPool* pool = nullptr;
+    // Файлы больше этого открываются без загрузки точек в память
+    size_t memoryLimit = OutOfCoreSweep::defaultMemoryLimit;
+    // Куда записать, докуда разобран файл, чтобы слежение продолжило с этого места;
+    // только для основного файла при включенном слежении
+    std::optional<LiveSweep::Origin>* followOrigin = nullptr;
+};
+
+static QString errorText(S11Parser::ParseResult result, const QString& filePath) {
     switch (result) {
         case S11Parser::ParseResult::Success:
-            errorMessage = "";
-            break;
+            return "";
         case S11Parser::ParseResult::FileNotFound:
-            errorMessage = "File not found: " + filePath;
-            break;
+            return "File not found: " + filePath;
         case S11Parser::ParseResult::InvalidFormat:
-            errorMessage = "Invalid Touchstone file format. Expected format: # Hz S RI R 50";
-            break;
+            return "Invalid Touchstone file format. Expected format: # Hz S RI R 50";
         case S11Parser::ParseResult::EmptyFile:
-            errorMessage = "File contains no valid data points";
-            break;
+            return "File contains no valid data points";
+        case S11Parser::ParseResult::Cancelled:
+            return "Loading cancelled";
+        case S11Parser::ParseResult::UnsortedFrequencies:
+            return "Files larger than the memory limit must list frequencies in ascending order";
+    }
+    return "";
+}
+
+// Файл больше лимита памяти: в снимке только пирамида, точки читаются из файла по требованию
+static ParseOutput loadOutOfCore(const LoadRequest& request) {
+    PERF_MEASURE("Backend::loadOutOfCore");
+    
+    OutOfCoreSweep::Options options;
+    options.memoryLimit = request.memoryLimit;
+    options.stopToken = request.options.stopToken;
+    options.bytesParsed = request.options.bytesParsed;
+    
+    auto opened = OutOfCoreSweep::open(request.filePath.toStdString(), options);
+    auto result = std::holds_alternative<OutOfCoreSweep::Ptr>(opened) ? S11Parser::ParseResult::Success
+                                                                      : std::get<S11Parser::ParseResult>(opened);
+    if (result == S11Parser::ParseResult::Success && options.stopToken.stop_requested()) {
+        result = S11Parser::ParseResult::Cancelled;
+    }
+    
+    MeasurementSnapshot::Ptr snapshot;
+    if (result == S11Parser::ParseResult::Success) {
+        snapshot = MeasurementSnapshot::createOutOfCore(std::get<OutOfCoreSweep::Ptr>(std::move(opened)));
+    }
+    return std::make_tuple(result, std::move(snapshot), errorText(result, request.filePath));
+}
+
+static ParseOutput parseFileAsync(LoadRequest request) {
+    PERF_MEASURE("Backend::parseFileAsync");
+    
+    if (static_cast<size_t>(QFileInfo(request.filePath).size()) > request.memoryLimit) {
+        return loadOutOfCore(request);
+    }
+    
+    const QString& filePath = request.filePath;
+    auto& options = request.options;
+    
+    // Состояние файла до разбора: если он изменится по ходу, слежение начнет с полного чтения
+    const auto before = request.followOrigin ? LiveSweep::fileState(filePath.toStdString()) : std::nullopt;
+    const auto makeSnapshot = [&request, &before](Measurement measurement, LodPyramid lod) {
+        if (!before) {
+            return MeasurementSnapshot::create(std::move(measurement), std::move(lod));
+        }
+        auto loaded = LiveSweep::createLoaded(request.filePath.toStdString(), *before, std::move(measurement),
+                                              std::move(lod));
+        *request.followOrigin = std::move(loaded.origin);
+        return loaded.snapshot;
+    };
+    
+    // Файл уже разбирался и не менялся — берем готовые столбцы и пирамиду из кэша
+    const auto& cache = request.cache;
+    const auto cacheKey = cache ? SweepCache::keyFor(filePath.toStdString()) : std::nullopt;
+    if (cacheKey) {
+        if (auto cached = cache->load(*cacheKey)) {
+            if (options.bytesParsed) {
+                options.bytesParsed->store(cacheKey->size, std::memory_order_relaxed);
+            }
+            auto snapshot = makeSnapshot(std::move(cached->measurement), std::move(cached->lod));
+            return std::make_tuple(S11Parser::ParseResult::Success, std::move(snapshot), QString());
+        }
     }
     
-    return std::make_tuple(result, std::move(measurement), errorMessage);
+    PreviewBuilder preview(request.publishPreview);
+    options.onBlock = [&preview](std::span<const double> frequency, std::span<const double> real,
+                                 std::span<const double> imag) {
+        preview.append(frequency, real, imag);
+    };
+    
+    Measurement measurement;
+    S11Parser::ParseResult result = S11Parser::parseFile(filePath.toStdString(), measurement, options);
+    
+    // Итоговый снимок забирает пирамиду, построенную по ходу разбора
+    MeasurementSnapshot::Ptr snapshot;
+    if (result == S11Parser::ParseResult::Success && options.stopToken.stop_requested()) {
+        result = S11Parser::ParseResult::Cancelled;
+    }
+    if (result == S11Parser::ParseResult::Success) {
+        snapshot = makeSnapshot(std::move(measurement), preview.takePyramid());
+        
+        // Запись в кэш идет отдельной задачей и не задерживает показ графика
+        if (cacheKey) {
+            request.pool->start([cache, key = *cacheKey, snapshot]() {
+                const auto& chunks = snapshot->chunks();
+                if (chunks.size() == 1) {
+                    cache->store(key, chunks.front()->measurement, chunks.front()->lod);
+                    return;
+                }
+                // Слежение отделило точки незавершенной строки в свой кусок: в кэш идет файл целиком
+                LodPyramid lod = chunks.front()->lod;
+                std::vector<const Measurement*> parts{&chunks.front()->measurement};
+                for (size_t i = 1; i < chunks.size(); ++i) {
+                    lod.append(chunks[i]->measurement.frequencies(), chunks[i]->measurement.logMagnitudes());
+                    parts.push_back(&chunks[i]->measurement);
+                }
+                cache->store(key, parts, lod);
+            });
+        }
+    }
+    
+    return std::make_tuple(result, std::move(snapshot), errorText(result, filePath));
+}
+
+struct Backend::EnvelopeJob {
+    std::mutex mutex;
+    SweepStatistics statistics;
+};
+
+static QString maskStatusText(const LimitMask::Result& result) {
+    if (result.checkedPoints == 0) {
+        return "Mask: no points under the mask";
+    }
+    const QString margin = QString("worst margin %1 dB at %2 MHz")
+                               .arg(result.worstMarginDb, 0, 'f', 2)
+                               .arg(result.worstFrequency / 1e6, 0, 'f', 3);
+    if (result.failedPoints > 0) {
+        return QString("Mask: FAIL, %1 points in %2 regions, ").arg(result.failedPoints).arg(result.violations.size()) + margin;
+    }
+    if (!result.complete) {
+        return "Mask: INCOMPLETE, the sweep does not cover the whole mask, " + margin;
+    }
+    return "Mask: PASS, " + margin;
+}
+
+// Пустая строка, если файл можно загружать
+static QString filePathError(const QString& filePath) {
+    if (filePath.isEmpty()) {
+        return "Invalid file path";
+    }
+    if (!filePath.toLower().endsWith(".s1p")) {
+        return "Unsupported file format. Please select a Touchstone (.s1p) file.";
+    }
+    return "";
 }
 
 Backend::Backend(QObject *parent)
     : QObject(parent)
     , m_graphWidget(nullptr)
-    , m_threadPool(std::make_unique<QThreadPool>()) {
+    , m_progressTimer(new QTimer(this))
+    , m_sweepCache(std::make_shared<SweepCache>(
+          QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("sweeps").toStdString()))
+    , m_followWatcher(new QFileSystemWatcher(this))
+    , m_followDebounce(new QTimer(this))
+    , m_followPoll(new QTimer(this))
+    , m_threadPool(std::make_unique<QThreadPool>())
+    , m_overlayPool(std::make_unique<QThreadPool>()) {
     
     const int idealThreadCount = std::max(2, QThread::idealThreadCount());
     m_threadPool->setMaxThreadCount(idealThreadCount);
+    m_overlayPool->setMaxThreadCount(std::min(idealThreadCount, maxConcurrentTraceLoads));
+    
+    // Прогресс опрашивается по таймеру, а не сигналом на каждый блок
+    m_progressTimer->setInterval(100);
+    connect(m_progressTimer, &QTimer::timeout, this, &Backend::updateLoadProgress);
+    
+    m_followDebounce->setSingleShot(true);
+    connect(m_followDebounce, &QTimer::timeout, this, &Backend::runFollowUpdate);
+    connect(m_followPoll, &QTimer::timeout, this, &Backend::pollFollowedFile);
+    connect(m_followWatcher, &QFileSystemWatcher::fileChanged, this, [this](const QString& path) {
+        if (path != m_filePath) {
+            return;
+        }
+        // Атомарная замена (запись во временный файл и rename) снимает путь с наблюдения
+        if (!m_followWatcher->files().contains(path)) {
+            m_followReplaced = true;
+            watchFollowedFile();
+        }
+        onFollowedFileChanged();
+    });
+    // Файл, созданный заново на том же месте, виден только по изменению каталога
+    connect(m_followWatcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+        if (m_liveSweep && !m_followWatcher->files().contains(m_filePath) && QFileInfo::exists(m_filePath)) {
+            m_followReplaced = true;
+            watchFollowedFile();
+            onFollowedFileChanged();
+        }
+    });
 }
 
 Backend::~Backend() {
     // Есть QThreadPool
 }
 
+void Backend::setGraphWidget(GraphWidget* widget) {
+    m_graphWidget = widget;
+    // Кадры графика растеризуются в том же пуле, что и парсинг
+    if (m_graphWidget) {
+        m_graphWidget->setThreadPool(m_threadPool.get());
+    }
+}
+
 void Backend::loadFile(const QUrl& fileUrl) {
-    QString filePath = fileUrl.toLocalFile();
-    
-    if (filePath.isEmpty()) {
-        setErrorMessage("Invalid file path");
+    const QString filePath = fileUrl.toLocalFile();
+    const QString error = filePathError(filePath);
+    if (!error.isEmpty()) {
+        setErrorMessage(error);
         return;
     }
     
-    if (!filePath.toLower().endsWith(".s1p")) {
-        setErrorMessage("Unsupported file format. Please select a Touchstone (.s1p) file.");
-        return;
+    // Один файл заменяет всю прежнюю выборку
+    clearOverlays();
+    startLoad(filePath, m_memoryLimit);
+}
+
+void Backend::loadFiles(const QList<QUrl>& fileUrls) {
+    QStringList filePaths;
+    QString rejectedError;
+    int rejected = 0;
+    for (const QUrl& fileUrl : fileUrls) {
+        const QString filePath = fileUrl.toLocalFile();
+        const QString error = filePathError(filePath);
+        if (error.isEmpty()) {
+            filePaths.append(filePath);
+        } else if (rejected++ == 0) {
+            rejectedError = QFileInfo(filePath).fileName() + ": " + error;
+        }
     }
     
-    if (m_isLoading) {
+    if (filePaths.isEmpty()) {
+        setErrorMessage(rejected > 0 ? rejectedError : "Invalid file path");
         return;
     }
     
+    // Лимит памяти делится на всю выборку: файлы больше своей доли открываются без загрузки точек
+    const size_t memoryLimit = std::max(m_memoryLimit / static_cast<size_t>(filePaths.size()), minTraceMemoryLimit);
+    
+    clearOverlays();
+    startLoad(filePaths.front(), filePaths.size() > 1 ? memoryLimit : m_memoryLimit);
+    startOverlayLoads(filePaths.mid(1), memoryLimit);
+    
+    // Отклоненные файлы попадают в итог выборки вместе с неразобранными
+    m_overlayTotal += rejected;
+    m_failedOverlays += rejected;
+    if (m_firstOverlayError.isEmpty()) {
+        m_firstOverlayError = rejectedError;
+    }
+}
+
+void Backend::startLoad(const QString& filePath, size_t memoryLimit) {
+    // Новая загрузка вытесняет текущую: та остановится на ближайшей границе блока
+    if (m_currentLoad) {
+        m_currentLoad->stopSource.request_stop();
+        PERF_ASYNC_END("Backend::load", m_loadGeneration);
+    } else {
+        // Данные до загрузки: к ним возвращаемся, если загрузка не удалась
+        m_snapshotBeforeLoad = m_snapshot.load();
+    }
+    
+    auto job = std::make_shared<LoadJob>();
+    job->totalBytes = static_cast<size_t>(QFileInfo(filePath).size());
+    job->timer.start();
+    m_currentLoad = job;
+    const quint64 generation = ++m_loadGeneration;
+    PERF_ASYNC_BEGIN("Backend::load", generation);
+    
     setIsLoading(true);
     setErrorMessage("");
+    setLoadProgress(0.0);
+    m_progressTimer->start();
     
-    auto future = QtConcurrent::run(m_threadPool.get(), parseFileAsync, filePath);
-    auto watcher = new QFutureWatcher<std::tuple<S11Parser::ParseResult, Measurement, QString>>(this);
+    // Пул уничтожается первым из членов Backend и дожидается задач, поэтому this здесь жив
+    const auto publishPreview = [this, generation](MeasurementSnapshot::Ptr preview) {
+        QMetaObject::invokeMethod(this, [this, generation, preview = std::move(preview)]() {
+            onPreviewReady(generation, preview);
+        }, Qt::QueuedConnection);
+    };
     
-    connect(watcher, &QFutureWatcher<std::tuple<S11Parser::ParseResult, Measurement, QString>>::finished,
-            this, [this, watcher]() {
-                auto result = watcher->result();
-                onParseCompleted(std::get<0>(result), std::move(std::get<1>(result)), std::get<2>(result));
+    LoadRequest request;
+    request.filePath = filePath;
+    request.options.stopToken = job->stopSource.get_token();
+    request.options.bytesParsed = &job->bytesParsed;
+    request.publishPreview = publishPreview;
+    request.cache = m_sweepCache;
+    request.pool = m_threadPool.get();
+    request.memoryLimit = memoryLimit;
+    // Без слежения место не запоминается: снимок остается одним куском со своей пирамидой
+    if (m_following) {
+        request.followOrigin = &job->followOrigin;
+    }
+    
+    // job держит счетчик байт и место для слежения, на которые ссылается request
+    auto future = QtConcurrent::run(m_threadPool.get(), [request = std::move(request), job]() {
+        return parseFileAsync(request);
+    });
+    auto watcher = new QFutureWatcher<ParseOutput>(this);
+    
+    connect(watcher, &QFutureWatcher<ParseOutput>::finished,
+            this, [this, watcher, generation, filePath]() {
+                // Результат вытесненной или отмененной загрузки сразу освобождается
+                if (generation == m_loadGeneration) {
+                    auto result = watcher->result();
+                    const double elapsedMs = static_cast<double>(m_currentLoad->timer.nsecsElapsed()) / 1e6;
+                    const size_t totalBytes = m_currentLoad->totalBytes;
+                    auto followOrigin = std::move(m_currentLoad->followOrigin);
+                    finishLoad();
+                    if (std::get<0>(result) == S11Parser::ParseResult::Success) {
+                        m_lastParseMs = elapsedMs;
+                        m_lastParseBytes = totalBytes;
+                        m_filePath = filePath;
+                        m_followOrigin = std::move(followOrigin);
+                        emit parseStatsChanged();
+                    }
+                    onParseCompleted(std::get<0>(result), std::move(std::get<1>(result)), std::get<2>(result));
+                }
                 watcher->deleteLater();
             });
     
     watcher->setFuture(future);
 
-    {
-        std::unique_lock lock(m_dataMutex);
-        m_zoomParams.isActive = false;
-    }
+    m_zoomParams.isActive = false;
     emit isZoomedChanged();
 }
 
-void Backend::clearData() {
-    {
-        std::unique_lock lock(m_dataMutex);
-        m_measurement.clear();
+void Backend::cancelLoad() {
+    // Уже показанные наложенные трассы и свернутые в огибающую свипы остаются на графике
+    cancelOverlayLoads();
+    cancelEnvelopeLoads();
+    
+    if (!m_currentLoad) {
+        return;
     }
     
+    m_currentLoad->stopSource.request_stop();
+    finishLoad();
+    ++m_loadGeneration;
+    restoreSnapshotBeforeLoad();
+    setIsLoading(false);
+}
+
+void Backend::onPreviewReady(quint64 generation, MeasurementSnapshot::Ptr preview) {
+    if (generation != m_loadGeneration) {
+        return;
+    }
+    PERF_MEASURE("Backend::onPreviewReady");
+    
+    // Результат маски относился к прежней трассе; на предпросмотре он не показывается
+    const auto previous = m_snapshot.load();
+    const bool firstPreview = !previous || !previous->isPreview();
+    
+    m_snapshot.store(preview);
+    setHasData(true);
+    emit dataPointCountChanged();
+    
+    if (m_graphWidget) {
+        m_graphWidget->setSnapshot(std::move(preview));
+    }
+    emit graphUpdated();
+    
+    if (m_mask && firstPreview) {
+        evaluateMask();
+    }
+}
+
+void Backend::restoreSnapshotBeforeLoad() {
+    auto previous = std::move(m_snapshotBeforeLoad);
+    m_snapshotBeforeLoad.reset();
+    
+    // Предпросмотр не показывался — возвращать нечего
+    if (m_snapshot.load() == previous) {
+        return;
+    }
+    
+    m_snapshot.store(previous);
+    setHasData(previous && !previous->empty());
+    emit dataPointCountChanged();
+    
+    if (m_graphWidget) {
+        m_graphWidget->setSnapshot(previous);
+    }
+    emit graphUpdated();
+    
+    if (m_mask) {
+        evaluateMask();
+    }
+}
+
+void Backend::finishLoad() {
+    PERF_ASYNC_END("Backend::load", m_loadGeneration);
+    m_progressTimer->stop();
+    m_currentLoad.reset();
+    setLoadProgress(0.0);
+}
+
+void Backend::updateLoadProgress() {
+    if (!m_currentLoad || m_currentLoad->totalBytes == 0) {
+        return;
+    }
+    
+    const size_t parsed = m_currentLoad->bytesParsed.load(std::memory_order_relaxed);
+    setLoadProgress(std::min(1.0, static_cast<double>(parsed) / static_cast<double>(m_currentLoad->totalBytes)));
+}
+
+void Backend::setLoadProgress(double progress) {
+    if (m_loadProgress != progress) {
+        m_loadProgress = progress;
+        emit loadProgressChanged();
+    }
+}
+
+QString Backend::cacheDirectory() const {
+    return QString::fromStdString(m_sweepCache->directory().string());
+}
+
+void Backend::setCacheDirectory(const QString& directory) {
+    if (directory == cacheDirectory()) {
+        return;
+    }
+    
+    // Уже запущенные загрузки дописывают кэш в прежний каталог
+    m_sweepCache->setDirectory(directory.toStdString());
+    emit cacheDirectoryChanged();
+}
+
+qint64 Backend::memoryLimitMb() const {
+    return static_cast<qint64>(m_memoryLimit / (1024 * 1024));
+}
+
+void Backend::setMemoryLimitMb(qint64 megabytes) {
+    const size_t limit = static_cast<size_t>(std::max<qint64>(megabytes, 1)) * 1024 * 1024;
+    if (m_memoryLimit != limit) {
+        m_memoryLimit = limit;
+        emit memoryLimitMbChanged();
+    }
+}
+
+double Backend::parseThroughputMBps() const {
+    if (m_lastParseMs <= 0.0) {
+        return 0.0;
+    }
+    return static_cast<double>(m_lastParseBytes) / (1024.0 * 1024.0) / (m_lastParseMs / 1000.0);
+}
+
+qint64 Backend::residentPoints() const {
+    const auto snapshot = m_snapshot.load();
+    const auto overlays = m_overlays.load();
+    return static_cast<qint64>((snapshot ? snapshot->residentPoints() : 0) +
+                               (overlays ? overlays->residentPoints() : 0));
+}
+
+qint64 Backend::residentBytes() const {
+    const auto snapshot = m_snapshot.load();
+    const auto overlays = m_overlays.load();
+    return static_cast<qint64>((snapshot ? snapshot->residentBytes() : 0) +
+                               (overlays ? overlays->residentBytes() : 0) + m_envelopeBytes);
+}
+
+int Backend::traceCount() const {
+    const auto snapshot = m_snapshot.load();
+    const auto overlays = m_overlays.load();
+    return (snapshot && !snapshot->empty() ? 1 : 0) + (overlays ? static_cast<int>(overlays->size()) : 0);
+}
+
+int Backend::envelopeSweeps() const {
+    const auto envelope = m_envelope.load();
+    return envelope ? static_cast<int>(envelope->sweepCount) : 0;
+}
+
+bool Backend::hasTraces() const {
+    const auto envelope = m_envelope.load();
+    return traceCount() > 0 || (envelope && !envelope->empty());
+}
+
+GraphRenderer::GraphBounds Backend::traceBounds() const {
+    return TraceSet::combinedBounds(m_snapshot.load(), m_overlays.load(), m_envelope.load());
+}
+
+GraphRenderer::GraphBounds Backend::autoScaleTraces(double freqMin, double freqMax) const {
+    GraphRenderer::GraphBounds bounds{freqMin, freqMax, 0.0, 0.0};
+    bool found = false;
+    
+    // Окно Y охватывает все трассы и огибающую, у которых есть точки в диапазоне частот
+    const auto include = [&](const GraphRenderer::GraphBounds& scaled) {
+        if (scaled.maxMag > scaled.minMag) {
+            bounds = found ? TraceSet::unite(bounds, scaled) : scaled;
+            found = true;
+        }
+    };
+    const auto includeSnapshot = [&](const MeasurementSnapshot& snapshot) {
+        include(GraphRenderer::autoScaleBounds(snapshot.parts(), freqMin, freqMax));
+    };
+    
+    if (const auto snapshot = m_snapshot.load(); snapshot && !snapshot->empty()) {
+        includeSnapshot(*snapshot);
+    }
+    if (const auto overlays = m_overlays.load()) {
+        for (const auto& trace : overlays->traces()) {
+            includeSnapshot(*trace.snapshot);
+        }
+    }
+    if (const auto envelope = m_envelope.load(); envelope && !envelope->empty()) {
+        include(GraphRenderer::autoScaleBounds(*envelope, freqMin, freqMax));
+    }
+    return bounds;
+}
+
+// Наложенные трассы
+
+void Backend::startOverlayLoads(const QStringList& filePaths, size_t memoryLimit) {
+    m_overlayTotal = static_cast<int>(filePaths.size());
+    m_pendingOverlays = m_overlayTotal;
+    m_failedOverlays = 0;
+    m_firstOverlayError.clear();
+    const quint64 generation = m_overlayGeneration;
+    
+    // Файлов больше, чем потоков пула, — каждый разбирается одним блоком в своем потоке
+    S11Parser::ParseOptions options;
+    options.stopToken = m_overlayStop.get_token();
+    if (filePaths.size() >= m_overlayPool->maxThreadCount()) {
+        options.parallelThreshold = std::numeric_limits<size_t>::max();
+    }
+    
+    for (qsizetype i = 0; i < filePaths.size(); ++i) {
+        LoadRequest request;
+        request.filePath = filePaths[i];
+        request.options = options;
+        request.cache = m_sweepCache;
+        request.pool = m_threadPool.get();
+        request.memoryLimit = memoryLimit;
+        
+        // В очереди пула ждут только запросы, разобранные данные появляются не больше чем у maxThreadCount файлов сразу
+        auto future = QtConcurrent::run(m_overlayPool.get(), [request = std::move(request)]() {
+            if (request.options.stopToken.stop_requested()) {
+                return ParseOutput{S11Parser::ParseResult::Cancelled, nullptr, QString()};
+            }
+            return parseFileAsync(request);
+        });
+        auto watcher = new QFutureWatcher<ParseOutput>(this);
+        
+        connect(watcher, &QFutureWatcher<ParseOutput>::finished,
+                this, [this, watcher, generation, colorIndex = static_cast<size_t>(i) + 1, filePath = filePaths[i]]() {
+                    // Результаты отмененной или замененной выборки сразу освобождаются
+                    if (generation == m_overlayGeneration) {
+                        auto [result, snapshot, errorMessage] = watcher->result();
+                        onOverlayCompleted(colorIndex, result, std::move(snapshot),
+                                           QFileInfo(filePath).fileName() + ": " + errorMessage);
+                    }
+                    watcher->deleteLater();
+                });
+        
+        watcher->setFuture(future);
+    }
+    
+    emit tracesChanged();
+}
+
+void Backend::onOverlayCompleted(size_t colorIndex, S11Parser::ParseResult result, MeasurementSnapshot::Ptr snapshot,
+                                 const QString& errorMessage) {
+    PERF_MEASURE("Backend::onOverlayCompleted");
+    
+    --m_pendingOverlays;
+    if (result == S11Parser::ParseResult::Success && snapshot) {
+        PERF_COUNTER("Backend::overlayPoints", snapshot->size());
+        m_overlayTraces.push_back({std::move(snapshot), colorIndex});
+        publishOverlays();
+    } else {
+        ++m_failedOverlays;
+        if (m_firstOverlayError.isEmpty()) {
+            m_firstOverlayError = errorMessage;
+        }
+    }
+    
+    // Итог по выборке, когда дочитаны все файлы; ошибка основного файла важнее
+    if (m_pendingOverlays == 0 && !m_currentLoad && m_errorMessage.isEmpty()) {
+        setErrorMessage(overlayErrorMessage());
+    }
+    emit tracesChanged();
+}
+
+QString Backend::overlayErrorMessage() const {
+    if (m_failedOverlays == 0) {
+        return "";
+    }
+    // Основной файл в выборке тоже считается; его ошибка выводится отдельно
+    return QString("%1 of %2 selected files could not be loaded. %3")
+        .arg(m_failedOverlays)
+        .arg(m_overlayTotal + 1)
+        .arg(m_firstOverlayError);
+}
+
+void Backend::publishOverlays() {
+    auto overlays = m_overlayTraces.empty() ? TraceSet::Ptr() : TraceSet::create(m_overlayTraces);
+    m_overlays.store(overlays);
+    
+    setHasData(hasTraces());
+    emit dataPointCountChanged();
+    
+    if (m_graphWidget) {
+        m_graphWidget->setOverlays(std::move(overlays));
+    }
+    emit graphUpdated();
+}
+
+void Backend::cancelOverlayLoads() {
+    // Задачи в очереди пула увидят отмену до чтения файла
+    m_overlayStop.request_stop();
+    m_overlayStop = std::stop_source();
+    ++m_overlayGeneration;
+    
+    if (m_pendingOverlays != 0) {
+        m_pendingOverlays = 0;
+        emit tracesChanged();
+    }
+}
+
+void Backend::clearOverlays() {
+    cancelOverlayLoads();
+    m_overlayTraces.clear();
+    m_failedOverlays = 0;
+    m_overlayTotal = 0;
+    m_firstOverlayError.clear();
+    
+    if (m_overlays.load()) {
+        publishOverlays();
+        emit tracesChanged();
+    }
+}
+
+// Огибающая статистики
+
+void Backend::loadEnvelope(const QList<QUrl>& fileUrls) {
+    QStringList filePaths;
+    QString rejectedError;
+    int rejected = 0;
+    for (const QUrl& fileUrl : fileUrls) {
+        const QString filePath = fileUrl.toLocalFile();
+        const QString error = filePathError(filePath);
+        if (error.isEmpty()) {
+            filePaths.append(filePath);
+        } else if (rejected++ == 0) {
+            rejectedError = QFileInfo(filePath).fileName() + ": " + error;
+        }
+    }
+    
+    if (filePaths.isEmpty()) {
+        setErrorMessage(rejected > 0 ? rejectedError : "Invalid file path");
+        return;
+    }
+    
+    // Новая выборка строит огибающую заново
+    cancelEnvelopeLoads();
+    m_envelopeJob = std::make_shared<EnvelopeJob>();
+    m_envelopeTotal = static_cast<int>(filePaths.size()) + rejected;
+    m_pendingEnvelope = static_cast<int>(filePaths.size());
+    m_failedEnvelope = rejected;
+    m_firstEnvelopeError = rejectedError;
+    m_envelopePublishTimer.start();
+    setErrorMessage("");
+    
+    // Сетку задает первый свернутый файл; пока ее нет, файлы разбираются по одному
+    m_envelopeQueue = filePaths.mid(1);
+    startEnvelopeLoads({filePaths.front()});
+    emit envelopeChanged();
+}
+
+void Backend::startEnvelopeLoads(const QStringList& filePaths) {
+    const quint64 generation = m_envelopeGeneration;
+    
+    S11Parser::ParseOptions options;
+    options.stopToken = m_envelopeStop.get_token();
+    if (filePaths.size() >= m_overlayPool->maxThreadCount()) {
+        options.parallelThreshold = std::numeric_limits<size_t>::max();
+    }
+    
+    for (const QString& filePath : filePaths) {
+        // Разобранный свип живет только до свертки; одновременно их не больше, чем потоков пула
+        auto future = QtConcurrent::run(m_overlayPool.get(), [job = m_envelopeJob, filePath, options]() {
+            PERF_MEASURE("Backend::foldEnvelopeFile");
+            if (options.stopToken.stop_requested()) {
+                return EnvelopeOutput{false, errorText(S11Parser::ParseResult::Cancelled, filePath)};
+            }
+            
+            auto parsed = S11Parser::parseFileExpected(filePath.toStdString(), nullptr, options);
+            const auto* measurement = std::get_if<Measurement>(&parsed);
+            if (!measurement) {
+                return EnvelopeOutput{false, errorText(std::get<S11Parser::ParseResult>(parsed), filePath)};
+            }
+            
+            // Логарифмы считаются до захвата мьютекса, под ним только свертка
+            static_cast<void>(measurement->logMagnitudes());
+            std::lock_guard lock(job->mutex);
+            if (!job->statistics.add(*measurement)) {
+                return EnvelopeOutput{false, "Frequencies do not overlap the envelope grid"};
+            }
+            return EnvelopeOutput{true, QString()};
+        });
+        auto watcher = new QFutureWatcher<EnvelopeOutput>(this);
+        
+        connect(watcher, &QFutureWatcher<EnvelopeOutput>::finished, this, [this, watcher, generation, filePath]() {
+            if (generation == m_envelopeGeneration) {
+                const auto [folded, errorMessage] = watcher->result();
+                onEnvelopeFileCompleted(folded, folded ? QString() : QFileInfo(filePath).fileName() + ": " + errorMessage);
+            }
+            watcher->deleteLater();
+        });
+        
+        watcher->setFuture(future);
+    }
+}
+
+void Backend::onEnvelopeFileCompleted(bool folded, const QString& errorMessage) {
+    --m_pendingEnvelope;
+    if (!folded) {
+        ++m_failedEnvelope;
+        if (m_firstEnvelopeError.isEmpty()) {
+            m_firstEnvelopeError = errorMessage;
+        }
+    }
+    
+    // Очередь непуста, только пока сетки нет и разбирается один файл. Свернутый
+    // свип задал сетку — остальные файлы разбираются параллельно; не свернутый —
+    // следующий файл, иначе сетку задал бы тот, чей разбор закончится первым
+    if (!m_envelopeQueue.isEmpty()) {
+        if (folded) {
+            startEnvelopeLoads(std::exchange(m_envelopeQueue, {}));
+        } else {
+            startEnvelopeLoads({m_envelopeQueue.takeFirst()});
+        }
+    }
+    
+    if (m_pendingEnvelope == 0 || (folded && m_envelopePublishTimer.elapsed() >= envelopePublishIntervalMs)) {
+        publishEnvelope();
+    }
+    if (m_pendingEnvelope == 0 && m_failedEnvelope > 0 && m_errorMessage.isEmpty()) {
+        setErrorMessage(QString("%1 of %2 envelope files could not be loaded. %3")
+                            .arg(m_failedEnvelope)
+                            .arg(m_envelopeTotal)
+                            .arg(m_firstEnvelopeError));
+    }
+    emit envelopeChanged();
+}
+
+void Backend::publishEnvelope() {
+    PERF_MEASURE("Backend::publishEnvelope");
+    
+    SweepStatistics::EnvelopePtr envelope;
+    m_envelopeBytes = 0;
+    if (m_envelopeJob) {
+        std::lock_guard lock(m_envelopeJob->mutex);
+        if (m_envelopeJob->statistics.sweepCount() > 0) {
+            envelope = m_envelopeJob->statistics.envelope();
+            m_envelopeBytes = m_envelopeJob->statistics.memoryBytes() + envelope->size() * 5 * sizeof(double);
+        }
+    }
+    m_envelope.store(envelope);
+    m_envelopePublishTimer.restart();
+    
+    setHasData(hasTraces());
+    emit dataPointCountChanged();
+    
+    if (m_graphWidget) {
+        m_graphWidget->setEnvelope(std::move(envelope));
+    }
+    emit graphUpdated();
+}
+
+void Backend::cancelEnvelopeLoads() {
+    m_envelopeStop.request_stop();
+    m_envelopeStop = std::stop_source();
+    ++m_envelopeGeneration;
+    m_envelopeQueue.clear();
+    
+    if (m_pendingEnvelope != 0) {
+        m_pendingEnvelope = 0;
+        // Уже свернутые свипы остаются в огибающей
+        publishEnvelope();
+        emit envelopeChanged();
+    }
+}
+
+void Backend::clearEnvelope() {
+    cancelEnvelopeLoads();
+    m_envelopeJob.reset();
+    m_failedEnvelope = 0;
+    m_envelopeTotal = 0;
+    m_firstEnvelopeError.clear();
+    
+    if (m_envelope.load()) {
+        publishEnvelope();
+        emit envelopeChanged();
+    }
+}
+
+// Маска допуска
+
+void Backend::loadMask(const QUrl& fileUrl) {
+    const QString filePath = fileUrl.toLocalFile();
+    if (filePath.isEmpty()) {
+        setErrorMessage("Invalid file path");
+        return;
+    }
+    
+    // Файл маски — несколько строк, читается сразу
+    auto loaded = LimitMask::load(filePath.toStdString());
+    if (const auto* error = std::get_if<LimitMask::LoadError>(&loaded)) {
+        setErrorMessage(QFileInfo(filePath).fileName() + (error->line ? QString(":%1").arg(error->line) : QString()) +
+                        ": " + QString::fromStdString(error->message));
+        return;
+    }
+    
+    m_mask = std::make_shared<const LimitMask>(std::move(std::get<LimitMask>(loaded)));
+    setErrorMessage("");
+    evaluateMask();
+}
+
+void Backend::clearMask() {
+    if (!m_mask) {
+        return;
+    }
+    m_mask.reset();
+    evaluateMask();
+}
+
+void Backend::evaluateMask() {
+    const quint64 generation = ++m_maskGeneration;
+    const auto snapshot = m_snapshot.load();
+    m_maskResult.reset();
+    
+    if (!m_mask) {
+        m_maskStatus.clear();
+        publishMask();
+        return;
+    }
+    if (!snapshot || snapshot->empty() || snapshot->isPreview()) {
+        m_maskStatus = snapshot && snapshot->isPreview() ? "Mask: waiting for the trace to load" : "Mask: no trace";
+        publishMask();
+        return;
+    }
+    
+    // Линии маски видны сразу, нарушения — когда проверка закончится
+    m_maskStatus = "Mask: checking...";
+    publishMask();
+    
+    auto future = QtConcurrent::run(m_threadPool.get(), [mask = m_mask, snapshot]() -> MaskOutput {
+        PERF_MEASURE("Backend::evaluateMask");
+        // Файл больше памяти: точки под маской дочитываются из файла, если их не слишком много
+        if (const auto& source = snapshot->outOfCore()) {
+            const auto window = source->readWindow(mask->minFrequency(), mask->maxFrequency());
+            if (!window) {
+                return nullptr;
+            }
+            return std::make_shared<const LimitMask::Result>(mask->evaluate(window->measurement));
+        }
+        // Куски снимка слежения за файлом проверяются без склейки
+        std::vector<const Measurement*> parts;
+        for (const auto& chunk : snapshot->chunks()) {
+            parts.push_back(&chunk->measurement);
+        }
+        return std::make_shared<const LimitMask::Result>(mask->evaluate(parts));
+    });
+    auto watcher = new QFutureWatcher<MaskOutput>(this);
+    
+    connect(watcher, &QFutureWatcher<MaskOutput>::finished, this, [this, watcher, generation]() {
+        if (generation == m_maskGeneration) {
+            m_maskResult = watcher->result();
+            m_maskStatus = m_maskResult ? maskStatusText(*m_maskResult)
+                                        : "Mask: too many points under the mask to check this file";
+            publishMask();
+        }
+        watcher->deleteLater();
+    });
+    
+    watcher->setFuture(future);
+}
+
+void Backend::publishMask() {
+    if (m_graphWidget) {
+        m_graphWidget->setLimitMask(m_mask, m_maskResult);
+    }
+    emit maskChanged();
+    emit graphUpdated();
+}
+
+// Слежение за файлом
+
+void Backend::setFollowing(bool enabled) {
+    if (m_following == enabled) {
+        return;
+    }
+    m_following = enabled;
+    emit followingChanged();
+    
+    if (!enabled) {
+        // Включенное снова слежение продолжит с того же места; LiveSweep, занятый
+        // обновлением в пуле, трогать нельзя — тогда файл будет прочитан заново
+        if (m_liveSweep && !m_followBusy) {
+            m_followOrigin = m_liveSweep->origin();
+        }
+        stopFollowing();
+        setFollowStatus("");
+    } else if (m_filePath.isEmpty()) {
+        setFollowStatus("Following: load a file to follow it");
+    } else {
+        startFollowing();
+    }
+}
+
+// Слежение продолжается с места, где остановилась загрузка файла (или прежнее
+// слежение): первое же изменение дочитывает только дописанные байты. Если файл
+// загружен при выключенном слежении, менялся во время загрузки или на графике
+// уже другой снимок, первое обновление разбирает файл целиком
+void Backend::startFollowing() {
+    stopFollowing();
+    auto origin = std::exchange(m_followOrigin, std::nullopt);
+    const std::string filePath = m_filePath.toStdString();
+    if (origin && origin->snapshot == m_snapshot.load()) {
+        m_liveSweep = std::make_shared<LiveSweep>(filePath, std::move(*origin));
+    } else {
+        m_liveSweep = std::make_shared<LiveSweep>(filePath);
+    }
+    
+    const QFileInfo info(m_filePath);
+    m_followWatcher->addPath(info.absolutePath());
+    watchFollowedFile();
+    m_followPolledSize = info.size();
+    m_followPolledTime = info.lastModified();
+    m_followPoll->start();
+    setFollowStatus("Following " + info.fileName() + ": waiting for changes");
+}
+
+void Backend::stopFollowing() {
+    // Обновление в пуле досчитается, но его результат не будет показан
+    m_liveSweep.reset();
+    m_followBusy = false;
+    m_followDirty = false;
+    m_followReplaced = false;
+    m_followPendingSince.invalidate();
+    m_followDebounce->stop();
+    m_followPoll->stop();
+    
+    const QStringList paths = m_followWatcher->files() + m_followWatcher->directories();
+    if (!paths.isEmpty()) {
+        m_followWatcher->removePaths(paths);
+    }
+}
+
+void Backend::watchFollowedFile() {
+    const bool watched = m_followWatcher->files().contains(m_filePath) ||
+                         (QFileInfo::exists(m_filePath) && m_followWatcher->addPath(m_filePath));
+    // Без наблюдателя (не поддерживается или файл пропал) изменения находит опрос
+    m_followPoll->setInterval(watched ? followSafetyPollMs : followPollMs);
+}
+
+void Backend::pollFollowedFile() {
+    const QFileInfo info(m_filePath);
+    if (info.size() == m_followPolledSize && info.lastModified() == m_followPolledTime) {
+        return;
+    }
+    m_followPolledSize = info.size();
+    m_followPolledTime = info.lastModified();
+    watchFollowedFile();
+    onFollowedFileChanged();
+}
+
+void Backend::onFollowedFileChanged() {
+    if (!m_liveSweep) {
+        return;
+    }
+    
+    // Серия событий сливается в одно обновление через followDebounceMs после последнего,
+    // но при непрерывной записи обновление выходит не реже раза в followMaxDelayMs
+    if (!m_followPendingSince.isValid()) {
+        m_followPendingSince.start();
+    }
+    if (!m_followDebounce->isActive() || m_followPendingSince.elapsed() < followMaxDelayMs) {
+        m_followDebounce->start(followDebounceMs);
+    }
+}
+
+void Backend::runFollowUpdate() {
+    m_followPendingSince.invalidate();
+    if (!m_liveSweep) {
+        return;
+    }
+    // Идет загрузка из файла: после нее слежение начнется заново, а при отмене — повторим
+    if (m_currentLoad) {
+        m_followDebounce->start(followSettleMs);
+        return;
+    }
+    if (m_followBusy) {
+        m_followDirty = true;
+        return;
+    }
+    
+    // Файл больше лимита памяти открывается без загрузки точек, дописывать их не к чему
+    if (static_cast<size_t>(QFileInfo(m_filePath).size()) > m_memoryLimit) {
+        setFollowStatus("Following paused: " + QFileInfo(m_filePath).fileName() + " is larger than the memory limit");
+        return;
+    }
+    
+    m_followBusy = true;
+    const bool replaced = std::exchange(m_followReplaced, false);
+    auto future = QtConcurrent::run(m_threadPool.get(), [live = m_liveSweep, replaced]() {
+        return live->update(replaced);
+    });
+    auto watcher = new QFutureWatcher<LiveSweep::Update>(this);
+    
+    connect(watcher, &QFutureWatcher<LiveSweep::Update>::finished, this, [this, watcher, live = m_liveSweep]() {
+        // Слежение за этим файлом уже остановлено или перезапущено
+        if (live == m_liveSweep) {
+            m_followBusy = false;
+            onFollowUpdate(watcher->result());
+        }
+        watcher->deleteLater();
+    });
+    
+    watcher->setFuture(future);
+}
+
+void Backend::onFollowUpdate(const LiveSweep::Update& update) {
+    PERF_MEASURE("Backend::onFollowUpdate");
+    
+    // Загрузка началась, пока шел разбор: точки не показаны, поэтому дальше файл читается с начала
+    if (m_currentLoad) {
+        m_liveSweep = std::make_shared<LiveSweep>(m_filePath.toStdString());
+        return;
+    }
+    
+    const QString fileName = QFileInfo(m_filePath).fileName();
+    if (update.snapshot) {
+        // Зум и наложенные трассы не трогаются; границы нового снимка уже посчитаны
+        m_snapshot.store(update.snapshot);
+        setHasData(true);
+        emit dataPointCountChanged();
+        
+        if (m_graphWidget) {
+            m_graphWidget->setSnapshot(update.snapshot);
+        }
+        emit graphUpdated();
+        
+        if (m_mask) {
+            evaluateMask();
+        }
+        
+        setFollowStatus(update.change == LiveSweep::Change::Reloaded
+            ? QString("Following %1: file rewritten, %2 points").arg(fileName).arg(update.snapshot->size())
+            : QString("Following %1: +%2 points, %3 total").arg(fileName).arg(update.newPoints).arg(update.snapshot->size()));
+    } else if (update.result != S11Parser::ParseResult::Success) {
+        // Прежняя трасса остается на графике, пока писатель не допишет новые точки
+        setFollowStatus(QString("Following %1: waiting for data (%2)").arg(fileName, errorText(update.result, m_filePath)));
+    }
+    
+    if (m_followDirty) {
+        m_followDirty = false;
+        onFollowedFileChanged();
+    } else if (update.pendingBytes > 0) {
+        // Последняя строка не завершена: если файл перестанет меняться, она покажется предварительной точкой
+        m_followDebounce->start(followSettleMs);
+    }
+}
+
+void Backend::setFollowStatus(const QString& status) {
+    if (m_followStatus != status) {
+        m_followStatus = status;
+        emit followingChanged();
+    }
+}
+
+void Backend::clearData() {
+    clearOverlays();
+    clearEnvelope();
+    // Включенное слежение ждет следующего файла
+    stopFollowing();
+    m_filePath.clear();
+    m_followOrigin.reset();
+    setFollowStatus(m_following ? "Following: load a file to follow it" : "");
+    m_snapshot.store(nullptr);
+    // Маска остается для следующего файла
+    evaluateMask();
+    
     setHasData(false);
     setErrorMessage("");
     emit dataPointCountChanged();
     
     if (m_graphWidget) {
-        m_graphWidget->updateMeasurement(m_measurement);
+        m_graphWidget->setSnapshot(nullptr);
         m_graphWidget->setZoomParams(m_zoomParams);
     }
     emit graphUpdated();
@@ -177,20 +1285,40 @@ void Backend::resetZoom() {
     emit graphUpdated();
 }
 
-void Backend::zoomToPixelRegion(int x1, int y1, int x2, int y2, int imageWidth, int imageHeight) {
-    std::shared_lock lock(m_dataMutex);
+void Backend::setAutoScaleY(bool enabled) {
+    if (m_autoScaleY == enabled) {
+        return;
+    }
+    m_autoScaleY = enabled;
+    emit autoScaleYChanged();
+    
+    // Включение при активном зуме сразу подгоняет Y под текущее окно
+    if (!enabled || !m_zoomParams.isActive) {
+        return;
+    }
     
-    if (m_measurement.empty()) {
+    if (!hasTraces()) {
         return;
     }
+    
+    const auto bounds = autoScaleTraces(m_zoomParams.freqMin, m_zoomParams.freqMax);
+    
+    if (bounds.maxMag > bounds.minMag) {
+        zoomToRegion(bounds.minFreq, bounds.maxFreq, bounds.minMag, bounds.maxMag);
+    }
+}
 
-    GraphRenderer::ZoomParams noZoom;
+void Backend::zoomToPixelRegion(int x1, int y1, int x2, int y2, int imageWidth, int imageHeight) {
+    // Снимки держатся до конца вызова, блокировки не нужны
+    if (!hasTraces()) {
+        return;
+    }
 
-    const auto originalBounds = GraphRenderer::calculateBounds(m_measurement, noZoom);
+    const auto originalBounds = traceBounds();
     
-    const auto currentBounds = GraphRenderer::calculateBounds(m_measurement, m_zoomParams);
+    const auto currentBounds = GraphRenderer::applyZoom(originalBounds, m_zoomParams);
     
-    constexpr int margin = 60;
+    constexpr int margin = PlotPainter::margin;
     
     const auto [minX, maxX] = std::minmax(x1, x2);
     const auto [minY, maxY] = std::minmax(y1, y2);
@@ -209,43 +1337,65 @@ void Backend::zoomToPixelRegion(int x1, int y1, int x2, int y2, int imageWidth,
     // Сжатие границ на основе границ до зума
     const double clampedFreqMin = std::clamp(freqMin, originalBounds.minFreq, originalBounds.maxFreq);
     const double clampedFreqMax = std::clamp(freqMax, originalBounds.minFreq, originalBounds.maxFreq);
-    const double clampedMagMin = std::clamp(magMin, originalBounds.minMag, originalBounds.maxMag);
-    const double clampedMagMax = std::clamp(magMax, originalBounds.minMag, originalBounds.maxMag);
+    double clampedMagMin = std::clamp(magMin, originalBounds.minMag, originalBounds.maxMag);
+    double clampedMagMax = std::clamp(magMax, originalBounds.minMag, originalBounds.maxMag);
+    
+    // Автомасштаб: выделение задает только частоту, Y берется по точкам в окне
+    if (m_autoScaleY && clampedFreqMax > clampedFreqMin) {
+        const auto scaled = autoScaleTraces(clampedFreqMin, clampedFreqMax);
+        clampedMagMin = scaled.minMag;
+        clampedMagMax = scaled.maxMag;
+    }
     
     //qDebug() << "Zoom selection: pixels(" << x1 << "," << y1 << "," << x2 << "," << y2 << ") size(" << imageWidth << "x" << imageHeight << ")";
     //qDebug() << "Current bounds: freq(" << currentBounds.minFreq << "-" << currentBounds.maxFreq << ") mag(" << currentBounds.minMag << "-" << currentBounds.maxMag << ")";
     //qDebug() << "Calculated zoom: freq(" << clampedFreqMin << "-" << clampedFreqMax << ") mag(" << clampedMagMin << "-" << clampedMagMax << ")";
     
     if (clampedFreqMax > clampedFreqMin && clampedMagMax > clampedMagMin) {
-        lock.unlock();
         zoomToRegion(clampedFreqMin, clampedFreqMax, clampedMagMin, clampedMagMax);
     } else {
         //qDebug() << "Invalid zoom region - skipping";
     }
 }
 
-void Backend::onParseCompleted(S11Parser::ParseResult result, Measurement measurement, QString errorMessage) {
+void Backend::onParseCompleted(S11Parser::ParseResult result, MeasurementSnapshot::Ptr snapshot, QString errorMessage) {
+    PERF_MEASURE("Backend::onParseCompleted");
+    
     setIsLoading(false);
     
-    if (result == S11Parser::ParseResult::Success) {
-        {
-            std::unique_lock lock(m_dataMutex);
-            m_measurement = std::move(measurement);
-        }
+    if (result == S11Parser::ParseResult::Success && snapshot) {
+        // Прежний снимок освобождается, когда его отпустит последний читатель
+        m_snapshot.store(snapshot);
+        m_snapshotBeforeLoad.reset();
+        PERF_COUNTER("Backend::loadedPoints", snapshot->size());
         
-        setErrorMessage("");
+        // Ошибки наложенных файлов той же выборки остаются видны
+        setErrorMessage(overlayErrorMessage());
         setHasData(true);
         emit dataPointCountChanged();
+        emit tracesChanged();
         
         if (m_graphWidget) {
-            m_graphWidget->updateMeasurement(m_measurement);
+            m_graphWidget->setSnapshot(std::move(snapshot));
             m_graphWidget->setZoomParams(m_zoomParams);
         }
         emit graphUpdated();
+        
+        if (m_mask) {
+            evaluateMask();
+        }
+        
+        // Слежение переходит на новый файл (или начинается заново с того же)
+        if (m_following) {
+            startFollowing();
+        }
     } else {
+        // Предпросмотр недогруженного файла убирается
+        restoreSnapshotBeforeLoad();
         setErrorMessage(errorMessage);
-        setHasData(false);
+        setHasData(hasTraces());
         emit dataPointCountChanged();
+        emit tracesChanged();
     }
 }
 
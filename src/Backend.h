@@ -8,11 +8,24 @@
 #include <QFutureWatcher>
 #include <QtConcurrent/QtConcurrent>
 #include <QThreadPool>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QFileSystemWatcher>
 #include <memory>
 #include <atomic>
-#include <shared_mutex>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <vector>
 #include "Measurement.h"
+#include "MeasurementSnapshot.h"
+#include "TraceSet.h"
+#include "SweepStatistics.h"
+#include "LimitMask.h"
+#include "LiveSweep.h"
 #include "S11Parser.h"
+#include "SweepCache.h"
 #include "GraphRenderer.h"
 
 class GraphWidget;
@@ -22,8 +35,26 @@ class Backend : public QObject {
     Q_PROPERTY(QString errorMessage READ errorMessage NOTIFY errorMessageChanged)
     Q_PROPERTY(bool hasData READ hasData NOTIFY hasDataChanged)
     Q_PROPERTY(bool isLoading READ isLoading NOTIFY isLoadingChanged)
+    Q_PROPERTY(double loadProgress READ loadProgress NOTIFY loadProgressChanged)
     Q_PROPERTY(int dataPointCount READ dataPointCount NOTIFY dataPointCountChanged)
     Q_PROPERTY(bool isZoomed READ isZoomed NOTIFY isZoomedChanged)
+    Q_PROPERTY(bool autoScaleY READ autoScaleY WRITE setAutoScaleY NOTIFY autoScaleYChanged)
+    Q_PROPERTY(QString cacheDirectory READ cacheDirectory WRITE setCacheDirectory NOTIFY cacheDirectoryChanged)
+    Q_PROPERTY(qint64 memoryLimitMb READ memoryLimitMb WRITE setMemoryLimitMb NOTIFY memoryLimitMbChanged)
+    Q_PROPERTY(double lastParseMs READ lastParseMs NOTIFY parseStatsChanged)
+    Q_PROPERTY(double parseThroughputMBps READ parseThroughputMBps NOTIFY parseStatsChanged)
+    Q_PROPERTY(qint64 residentPoints READ residentPoints NOTIFY dataPointCountChanged)
+    Q_PROPERTY(qint64 residentBytes READ residentBytes NOTIFY dataPointCountChanged)
+    Q_PROPERTY(int traceCount READ traceCount NOTIFY tracesChanged)
+    Q_PROPERTY(int pendingTraceLoads READ pendingTraceLoads NOTIFY tracesChanged)
+    Q_PROPERTY(int envelopeSweeps READ envelopeSweeps NOTIFY envelopeChanged)
+    Q_PROPERTY(int pendingEnvelopeLoads READ pendingEnvelopeLoads NOTIFY envelopeChanged)
+    Q_PROPERTY(bool hasMask READ hasMask NOTIFY maskChanged)
+    Q_PROPERTY(bool maskPassed READ maskPassed NOTIFY maskChanged)
+    Q_PROPERTY(bool maskFailed READ maskFailed NOTIFY maskChanged)
+    Q_PROPERTY(QString maskStatus READ maskStatus NOTIFY maskChanged)
+    Q_PROPERTY(bool following READ following WRITE setFollowing NOTIFY followingChanged)
+    Q_PROPERTY(QString followStatus READ followStatus NOTIFY followingChanged)
 
 public:
     explicit Backend(QObject *parent = nullptr);
@@ -32,17 +63,67 @@ public:
     QString errorMessage() const { return m_errorMessage; }
     bool hasData() const { return m_hasData.load(); }
     bool isLoading() const { return m_isLoading.load(); }
+    double loadProgress() const { return m_loadProgress; }
     int dataPointCount() const { 
-        std::shared_lock lock(m_dataMutex); 
-        return static_cast<int>(m_measurement.size()); 
+        const auto snapshot = m_snapshot.load();
+        return snapshot ? static_cast<int>(snapshot->size()) : 0; 
     }
     bool isZoomed() const { return m_zoomParams.isActive; }
+    bool autoScaleY() const { return m_autoScaleY; }
     
-    Q_INVOKABLE void setGraphWidget(GraphWidget* widget) { m_graphWidget = widget; }
+    void setAutoScaleY(bool enabled);
+    
+    // Каталог бинарного кэша разобранных файлов
+    QString cacheDirectory() const;
+    void setCacheDirectory(const QString& directory);
+    
+    // Файлы больше лимита открываются без загрузки точек (OutOfCoreSweep),
+    // пирамида и индекс такого файла укладываются в тот же лимит
+    qint64 memoryLimitMb() const;
+    void setMemoryLimitMb(qint64 megabytes);
+    
+    // Последняя успешная загрузка: от loadFile до готового снимка, включая
+    // попадания в кэш; пропускная способность — по размеру файла
+    double lastParseMs() const { return m_lastParseMs; }
+    double parseThroughputMBps() const;
+    // Считаются по текущему снимку и наложенным трассам при чтении
+    qint64 residentPoints() const;
+    qint64 residentBytes() const;
+    
+    // Трассы на графике: основная и наложенные из той же выборки файлов
+    int traceCount() const;
+    int pendingTraceLoads() const { return m_pendingOverlays; }
+    
+    // Статистика по свипам: сколько файлов уже свернуто в огибающую и сколько в очереди
+    int envelopeSweeps() const;
+    int pendingEnvelopeLoads() const { return m_pendingEnvelope; }
+    
+    // Маска допуска: проверяется основная трасса, нарушения подсвечиваются на графике
+    bool hasMask() const { return m_mask != nullptr; }
+    bool maskPassed() const { return m_maskResult && m_maskResult->passed(); }
+    bool maskFailed() const { return m_maskResult && m_maskResult->failedPoints > 0; }
+    QString maskStatus() const { return m_maskStatus; }
+    
+    // Слежение за файлом основной трассы: дописанные строки добавляются к графику,
+    // переписанный файл перечитывается. Включенное слежение переходит на каждый
+    // новый загруженный файл
+    bool following() const { return m_following; }
+    void setFollowing(bool enabled);
+    QString followStatus() const { return m_followStatus; }
+    
+    Q_INVOKABLE void setGraphWidget(GraphWidget* widget);
     GraphWidget* getGraphWidget() const { return m_graphWidget; }
 
 public slots:
     void loadFile(const QUrl& fileUrl);
+    // Несколько файлов сразу: первый — основная трасса, остальные накладываются на нее
+    Q_INVOKABLE void loadFiles(const QList<QUrl>& fileUrls);
+    // Среднее, СКО и min/max по многим свипам; свипы после свертки не хранятся
+    Q_INVOKABLE void loadEnvelope(const QList<QUrl>& fileUrls);
+    Q_INVOKABLE void clearEnvelope();
+    Q_INVOKABLE void loadMask(const QUrl& fileUrl);
+    Q_INVOKABLE void clearMask();
+    void cancelLoad();
     void clearData();
     void zoomToRegion(double freqMin, double freqMax, double magMin, double magMax);
     void resetZoom();
@@ -52,27 +133,158 @@ signals:
     void errorMessageChanged();
     void hasDataChanged();
     void isLoadingChanged();
+    void loadProgressChanged();
     void dataPointCountChanged();
     void graphUpdated();
     void isZoomedChanged();
+    void autoScaleYChanged();
+    void cacheDirectoryChanged();
+    void memoryLimitMbChanged();
+    void parseStatsChanged();
+    void tracesChanged();
+    void envelopeChanged();
+    void maskChanged();
+    void followingChanged();
 
 private slots:
-    void onParseCompleted(S11Parser::ParseResult result, Measurement measurement, QString errorMessage);
+    void onParseCompleted(S11Parser::ParseResult result, MeasurementSnapshot::Ptr snapshot, QString errorMessage);
+    void onPreviewReady(quint64 generation, MeasurementSnapshot::Ptr preview);
 
 private:
     void setErrorMessage(const QString& message);
     void setHasData(bool hasData);
     void setIsLoading(bool loading);
     void setIsZoomed(bool zoomed);
+    void setLoadProgress(double progress);
+    void updateLoadProgress();
+    void finishLoad();
+    void restoreSnapshotBeforeLoad();
+    void startLoad(const QString& filePath, size_t memoryLimit);
+    
+    // Наложенные трассы
+    void startOverlayLoads(const QStringList& filePaths, size_t memoryLimit);
+    void onOverlayCompleted(size_t colorIndex, S11Parser::ParseResult result, MeasurementSnapshot::Ptr snapshot,
+                            const QString& errorMessage);
+    void cancelOverlayLoads();
+    void clearOverlays();
+    void publishOverlays();
+    [[nodiscard]] QString overlayErrorMessage() const;
+    [[nodiscard]] bool hasTraces() const;
+    // Границы всех трасс и автомасштаб Y по всем трассам в окне частот
+    [[nodiscard]] GraphRenderer::GraphBounds traceBounds() const;
+    [[nodiscard]] GraphRenderer::GraphBounds autoScaleTraces(double freqMin, double freqMax) const;
+    
+    // Огибающая статистики
+    struct EnvelopeJob;
+    void startEnvelopeLoads(const QStringList& filePaths);
+    void onEnvelopeFileCompleted(bool folded, const QString& errorMessage);
+    void publishEnvelope();
+    void cancelEnvelopeLoads();
+    
+    // Проверка основной трассы по маске в пуле; устаревшие результаты отбрасываются
+    void evaluateMask();
+    void publishMask();
+    
+    // Слежение за файлом
+    void startFollowing();
+    void stopFollowing();
+    void watchFollowedFile();
+    void onFollowedFileChanged();
+    void pollFollowedFile();
+    void runFollowUpdate();
+    void onFollowUpdate(const LiveSweep::Update& update);
+    void setFollowStatus(const QString& status);
+    
+    // Одна загрузка: флаг отмены и счетчик байт общие с рабочим потоком
+    struct LoadJob {
+        std::stop_source stopSource;
+        std::atomic<size_t> bytesParsed{0};
+        size_t totalBytes = 0;
+        QElapsedTimer timer;
+        // Место, с которого слежение продолжит загруженный файл
+        std::optional<LiveSweep::Origin> followOrigin;
+    };
     
     QString m_errorMessage;
     std::atomic<bool> m_hasData{false};
     std::atomic<bool> m_isLoading{false};
-    Measurement m_measurement;
+    // Текущий снимок данных; читатели берут копию указателя без блокировок
+    std::atomic<MeasurementSnapshot::Ptr> m_snapshot;
     GraphWidget* m_graphWidget;
     GraphRenderer::ZoomParams m_zoomParams;
+    bool m_autoScaleY = false;
+    
+    // Загрузка: новая вытесняет текущую, результаты старых поколений отбрасываются
+    std::shared_ptr<LoadJob> m_currentLoad;
+    quint64 m_loadGeneration = 0;
+    double m_loadProgress = 0.0;
+    // Что показывалось до загрузки: возвращается при отмене или ошибке после предпросмотра
+    MeasurementSnapshot::Ptr m_snapshotBeforeLoad;
+    QTimer* m_progressTimer;
+    double m_lastParseMs = 0.0;
+    size_t m_lastParseBytes = 0;
+    
+    // Общий с рабочими задачами: запись кэша может пережить загрузку
+    std::shared_ptr<SweepCache> m_sweepCache;
+    size_t m_memoryLimit = 2ull * 1024 * 1024 * 1024;
+    
+    // Наложенные трассы: публикуются так же, как снимок. Загрузки одной
+    // выборки отменяются вместе, результаты прошлых выборок отбрасываются
+    std::atomic<TraceSet::Ptr> m_overlays;
+    std::vector<TraceSet::Trace> m_overlayTraces;
+    std::stop_source m_overlayStop;
+    quint64 m_overlayGeneration = 0;
+    int m_pendingOverlays = 0;
+    int m_failedOverlays = 0;
+    int m_overlayTotal = 0;
+    QString m_firstOverlayError;
+    
+    // Огибающая: накопители общие с рабочими задачами (свертка под мьютексом задания),
+    // на график идет неизменяемый снимок. Первый файл задает сетку и сворачивается
+    // до запуска остальных, поэтому сетка не зависит от порядка завершения
+    std::shared_ptr<EnvelopeJob> m_envelopeJob;
+    std::atomic<SweepStatistics::EnvelopePtr> m_envelope;
+    QStringList m_envelopeQueue;
+    std::stop_source m_envelopeStop;
+    quint64 m_envelopeGeneration = 0;
+    int m_pendingEnvelope = 0;
+    int m_failedEnvelope = 0;
+    int m_envelopeTotal = 0;
+    QString m_firstEnvelopeError;
+    QElapsedTimer m_envelopePublishTimer;
+    size_t m_envelopeBytes = 0;
+    
+    // Маска и результат проверки текущего снимка; меняются только в потоке GUI
+    LimitMask::Ptr m_mask;
+    LimitMask::ResultPtr m_maskResult;
+    QString m_maskStatus;
+    quint64 m_maskGeneration = 0;
+    
+    // Слежение: события наблюдателя и опроса сливаются таймером m_followDebounce,
+    // разбор идет в пуле, одновременно не больше одного обновления.
+    // LiveSweep заменяется при смене файла, результаты прежнего отбрасываются
+    bool m_following = false;
+    // Файл основной трассы из последней успешной загрузки
+    QString m_filePath;
+    QString m_followStatus;
+    QFileSystemWatcher* m_followWatcher;
+    QTimer* m_followDebounce;
+    QTimer* m_followPoll;
+    QElapsedTimer m_followPendingSince;
+    LiveSweep::Ptr m_liveSweep;
+    // Докуда разобран m_filePath загрузкой или выключенным слежением: с этого места
+    // слежение продолжается, если на графике все еще тот же снимок
+    std::optional<LiveSweep::Origin> m_followOrigin;
+    bool m_followBusy = false;
+    bool m_followDirty = false;
+    bool m_followReplaced = false;
+    qint64 m_followPolledSize = -1;
+    QDateTime m_followPolledTime;
     
     // Threading
     std::unique_ptr<QThreadPool> m_threadPool;
-    mutable std::shared_mutex m_dataMutex;
+    // Отдельный небольшой пул для наложенных трасс и огибающей: сколько файлов
+    // читается с диска одновременно.
+    // Уничтожается первым и дожидается своих задач
+    std::unique_ptr<QThreadPool> m_overlayPool;
 };
\ No newline at end of file
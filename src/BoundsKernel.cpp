@@ -0,0 +1,177 @@
+#include "BoundsKernel.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#ifdef TOUCHSTONE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using KernelFn = BoundsKernel::Extents (*)(const double*, const double*, const double*, size_t) noexcept;
+
+BoundsKernel::Extents computeScalar(const double* freq, const double* re, const double* im, size_t n) noexcept {
+    BoundsKernel::Extents extents;
+    for (size_t i = 0; i < n; ++i) {
+        const double power = re[i] * re[i] + im[i] * im[i];
+        extents.minFreq = std::min(extents.minFreq, freq[i]);
+        extents.maxFreq = std::max(extents.maxFreq, freq[i]);
+        extents.minPower = std::min(extents.minPower, power);
+        extents.maxPower = std::max(extents.maxPower, power);
+    }
+    return extents;
+}
+
+#ifdef TOUCHSTONE_X86
+
+BoundsKernel::Extents computeSse2(const double* freq, const double* re, const double* im, size_t n) noexcept {
+    __m128d minFreq = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    __m128d maxFreq = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    __m128d minPower = minFreq;
+    __m128d maxPower = maxFreq;
+    
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d f = _mm_loadu_pd(freq + i);
+        const __m128d r = _mm_loadu_pd(re + i);
+        const __m128d m = _mm_loadu_pd(im + i);
+        const __m128d power = _mm_add_pd(_mm_mul_pd(r, r), _mm_mul_pd(m, m));
+        minFreq = _mm_min_pd(minFreq, f);
+        maxFreq = _mm_max_pd(maxFreq, f);
+        minPower = _mm_min_pd(minPower, power);
+        maxPower = _mm_max_pd(maxPower, power);
+    }
+    
+    alignas(16) double lanes[4][2];
+    _mm_store_pd(lanes[0], minFreq);
+    _mm_store_pd(lanes[1], maxFreq);
+    _mm_store_pd(lanes[2], minPower);
+    _mm_store_pd(lanes[3], maxPower);
+    
+    BoundsKernel::Extents extents = computeScalar(freq + i, re + i, im + i, n - i);
+    for (int lane = 0; lane < 2; ++lane) {
+        extents.minFreq = std::min(extents.minFreq, lanes[0][lane]);
+        extents.maxFreq = std::max(extents.maxFreq, lanes[1][lane]);
+        extents.minPower = std::min(extents.minPower, lanes[2][lane]);
+        extents.maxPower = std::max(extents.maxPower, lanes[3][lane]);
+    }
+    return extents;
+}
+
+// Два независимых набора аккумуляторов скрывают задержку min/max
+TOUCHSTONE_TARGET_AVX2
+BoundsKernel::Extents computeAvx2(const double* freq, const double* re, const double* im, size_t n) noexcept {
+    const __m256d posInf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    const __m256d negInf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    __m256d minFreq[2] = {posInf, posInf};
+    __m256d maxFreq[2] = {negInf, negInf};
+    __m256d minPower[2] = {posInf, posInf};
+    __m256d maxPower[2] = {negInf, negInf};
+    
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 2; ++k) {
+            const size_t j = i + 4 * k;
+            const __m256d f = _mm256_loadu_pd(freq + j);
+            const __m256d r = _mm256_loadu_pd(re + j);
+            const __m256d m = _mm256_loadu_pd(im + j);
+            const __m256d power = _mm256_add_pd(_mm256_mul_pd(r, r), _mm256_mul_pd(m, m));
+            minFreq[k] = _mm256_min_pd(minFreq[k], f);
+            maxFreq[k] = _mm256_max_pd(maxFreq[k], f);
+            minPower[k] = _mm256_min_pd(minPower[k], power);
+            maxPower[k] = _mm256_max_pd(maxPower[k], power);
+        }
+    }
+    
+    alignas(32) double lanes[4][4];
+    _mm256_store_pd(lanes[0], _mm256_min_pd(minFreq[0], minFreq[1]));
+    _mm256_store_pd(lanes[1], _mm256_max_pd(maxFreq[0], maxFreq[1]));
+    _mm256_store_pd(lanes[2], _mm256_min_pd(minPower[0], minPower[1]));
+    _mm256_store_pd(lanes[3], _mm256_max_pd(maxPower[0], maxPower[1]));
+    
+    BoundsKernel::Extents extents = computeScalar(freq + i, re + i, im + i, n - i);
+    for (int lane = 0; lane < 4; ++lane) {
+        extents.minFreq = std::min(extents.minFreq, lanes[0][lane]);
+        extents.maxFreq = std::max(extents.maxFreq, lanes[1][lane]);
+        extents.minPower = std::min(extents.minPower, lanes[2][lane]);
+        extents.maxPower = std::max(extents.maxPower, lanes[3][lane]);
+    }
+    return extents;
+}
+
+#endif
+
+KernelFn selectKernel() noexcept {
+#ifdef TOUCHSTONE_X86
+    if (CpuFeatures::hasAvx2()) {
+        return computeAvx2;
+    }
+    if (CpuFeatures::hasSse2()) {
+        return computeSse2;
+    }
+#endif
+    return computeScalar;
+}
+
+} // namespace
+
+double BoundsKernel::Extents::minMagDb() const noexcept {
+    return 10.0 * std::log10(minPower);
+}
+
+double BoundsKernel::Extents::maxMagDb() const noexcept {
+    return 10.0 * std::log10(maxPower);
+}
+
+BoundsKernel::Extents BoundsKernel::merge(const Extents& a, const Extents& b) noexcept {
+    return Extents{
+        std::min(a.minFreq, b.minFreq),
+        std::max(a.maxFreq, b.maxFreq),
+        std::min(a.minPower, b.minPower),
+        std::max(a.maxPower, b.maxPower)
+    };
+}
+
+BoundsKernel::Extents BoundsKernel::compute(std::span<const double> frequency,
+                                            std::span<const double> real,
+                                            std::span<const double> imag) noexcept {
+    static const KernelFn kernel = selectKernel();
+    const size_t n = std::min({frequency.size(), real.size(), imag.size()});
+    return kernel(frequency.data(), real.data(), imag.data(), n);
+}
+
+BoundsKernel::Extents BoundsKernel::computeParallel(std::span<const double> frequency,
+                                                    std::span<const double> real,
+                                                    std::span<const double> imag) {
+    constexpr size_t minChunkPoints = 64 * 1024;
+    const size_t n = std::min({frequency.size(), real.size(), imag.size()});
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunkCount = std::clamp(n / minChunkPoints, size_t(1), threads * 4);
+    
+    if (chunkCount == 1) {
+        return compute(frequency, real, imag);
+    }
+    
+    // Только номера блоков, по одному на блок, а не по элементу на точку
+    std::vector<size_t> chunks(chunkCount);
+    std::iota(chunks.begin(), chunks.end(), size_t(0));
+    
+    return std::transform_reduce(
+        std::execution::par,
+        chunks.begin(), chunks.end(),
+        Extents{},
+        [](const Extents& a, const Extents& b) { return merge(a, b); },
+        [&](size_t chunk) {
+            const size_t begin = n * chunk / chunkCount;
+            const size_t end = n * (chunk + 1) / chunkCount;
+            return compute(frequency.subspan(begin, end - begin),
+                           real.subspan(begin, end - begin),
+                           imag.subspan(begin, end - begin));
+        }
+    );
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <span>
+
+// Однопроходный поиск min/max частоты и |S11|^2 по столбцам Measurement.
+// log10 берется только для найденных крайних значений, а не для каждой точки.
+class BoundsKernel {
+public:
+    struct Extents {
+        double minFreq = std::numeric_limits<double>::infinity();
+        double maxFreq = -std::numeric_limits<double>::infinity();
+        double minPower = std::numeric_limits<double>::infinity();
+        double maxPower = -std::numeric_limits<double>::infinity();
+        
+        [[nodiscard]] bool isValid() const noexcept { return minFreq <= maxFreq; }
+        [[nodiscard]] double minMagDb() const noexcept;
+        [[nodiscard]] double maxMagDb() const noexcept;
+    };
+    
+    [[nodiscard]] static Extents merge(const Extents& a, const Extents& b) noexcept;
+    
+    // Один поток, SIMD (AVX2 / SSE2 / скалярно)
+    [[nodiscard]] static Extents compute(std::span<const double> frequency,
+                                         std::span<const double> real,
+                                         std::span<const double> imag) noexcept;
+    
+    // Параллельно по блокам, частичные результаты сводятся в transform_reduce
+    [[nodiscard]] static Extents computeParallel(std::span<const double> frequency,
+                                                 std::span<const double> real,
+                                                 std::span<const double> imag);
+};
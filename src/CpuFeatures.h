@@ -0,0 +1,58 @@
+#pragma once
+
+// Определение доступных SIMD-расширений во время выполнения
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TOUCHSTONE_X86 1
+#endif
+
+#if defined(TOUCHSTONE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TOUCHSTONE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TOUCHSTONE_TARGET_AVX2
+#endif
+
+#if defined(TOUCHSTONE_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace CpuFeatures {
+
+[[nodiscard]] inline bool hasSse2() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true; // Базовый набор x86-64
+#elif defined(TOUCHSTONE_X86) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_cpu_supports("sse2");
+#elif defined(TOUCHSTONE_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return false;
+#endif
+}
+
+[[nodiscard]] inline bool hasAvx2() noexcept {
+#if defined(TOUCHSTONE_X86) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_cpu_supports("avx2");
+#elif defined(TOUCHSTONE_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) {
+        return false;
+    }
+    // ОС должна сохранять YMM-регистры
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace CpuFeatures
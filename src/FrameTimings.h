@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// Скользящее окно длительностей (мс) последних кадров: последнее значение
+// и перцентили по окну. Без синхронизации — ее обеспечивает владелец.
+class FrameTimings {
+public:
+    static constexpr size_t windowSize = 240;
+    
+    void add(double milliseconds) noexcept {
+        m_samples[m_next] = milliseconds;
+        m_next = (m_next + 1) % windowSize;
+        m_count = std::min(m_count + 1, windowSize);
+        m_last = milliseconds;
+    }
+    
+    void clear() noexcept {
+        m_next = 0;
+        m_count = 0;
+        m_last = 0.0;
+    }
+    
+    [[nodiscard]] size_t count() const noexcept { return m_count; }
+    [[nodiscard]] double last() const noexcept { return m_last; }
+    
+    // p в [0, 1], ближайший ранг; 0, пока окно пустое
+    [[nodiscard]] double percentile(double p) const {
+        if (m_count == 0) {
+            return 0.0;
+        }
+        
+        std::array<double, windowSize> sorted;
+        std::copy_n(m_samples.begin(), m_count, sorted.begin());
+        
+        const auto rank = static_cast<size_t>(std::ceil(std::clamp(p, 0.0, 1.0) * static_cast<double>(m_count)));
+        const size_t index = std::clamp<size_t>(rank, 1, m_count) - 1;
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + m_count);
+        return sorted[index];
+    }
+    
+private:
+    std::array<double, windowSize> m_samples{};
+    size_t m_next = 0;
+    size_t m_count = 0;
+    double m_last = 0.0;
+};
@@ -1,11 +1,70 @@
 #include "GraphRenderer.h"
+#include "BoundsKernel.h"
+#include "PerformanceUtils.h"
 #include <cmath>
 #include <algorithm>
 #include <execution>
+#include <tuple>
 #include <QFont>
 #include <QFuture>
 #include <QtConcurrent/QtConcurrent>
 
+namespace {
+constexpr size_t parallelBoundsThreshold = 256 * 1024;
+constexpr double freqPadding = 0.05;
+constexpr double magPadding = 0.1;
+
+void addPadding(GraphRenderer::GraphBounds& bounds) {
+    const double freqRange = bounds.maxFreq - bounds.minFreq;
+    const double magRange = bounds.maxMag - bounds.minMag;
+    
+    bounds.minFreq -= freqRange * freqPadding;
+    bounds.maxFreq += freqRange * freqPadding;
+    bounds.minMag -= magRange * magPadding;
+    bounds.maxMag += magRange * magPadding;
+}
+
+// Окно |S11| по диапазону значений с отступом; плоский участок — минимальная высота окна 1 дБ
+void fitMagnitudes(GraphRenderer::GraphBounds& bounds, double minValue, double maxValue) {
+    constexpr double minMagSpan = 1.0;
+    const double center = 0.5 * (minValue + maxValue);
+    const double halfSpan = 0.5 * std::max(maxValue - minValue, minMagSpan) * (1.0 + 2.0 * magPadding);
+    bounds.minMag = center - halfSpan;
+    bounds.maxMag = center + halfSpan;
+}
+
+// Min/max |S11| точек в [freqMin, freqMax]; окно уже шага сетки — по соседям, между которыми проходит линия
+LodPyramid::ValueRange magnitudeRange(const Measurement& measurement, const LodPyramid& lod,
+                                      double freqMin, double freqMax) {
+    const auto frequencies = measurement.frequencies();
+    const auto magnitudes = measurement.logMagnitudes();
+    
+    LodPyramid::ValueRange range;
+    if (lod.isValid() && measurement.empty()) {
+        // Точки не загружены (предпросмотр, файл больше памяти): по корзинам пирамиды
+        range = lod.rangeMinMax(freqMin, freqMax);
+    } else if (lod.isValid() && measurement.isSortedByFrequency()) {
+        const auto first = std::lower_bound(frequencies.begin(), frequencies.end(), freqMin);
+        const auto last = std::upper_bound(first, frequencies.end(), freqMax);
+        size_t begin = static_cast<size_t>(first - frequencies.begin());
+        size_t end = static_cast<size_t>(last - frequencies.begin());
+        
+        if (begin == end) {
+            std::tie(begin, end) = measurement.visibleRange(freqMin, freqMax);
+        }
+        range = lod.rangeMinMax(begin, end, magnitudes);
+    } else {
+        for (size_t i = 0; i < frequencies.size(); ++i) {
+            if (frequencies[i] >= freqMin && frequencies[i] <= freqMax) {
+                range.min = std::min(range.min, magnitudes[i]);
+                range.max = std::max(range.max, magnitudes[i]);
+            }
+        }
+    }
+    return range;
+}
+}
+
 GraphRenderer::GraphBounds GraphRenderer::calculateBounds(const Measurement& measurement) {
     ZoomParams defaultZoom;
     return calculateBounds(measurement, defaultZoom);
@@ -32,64 +91,160 @@ GraphRenderer::GraphBounds GraphRenderer::calculateBounds(const Measurement& mea
         }
     }
     
-    const auto& data = measurement.data;
+    // Один проход по столбцам: min/max частоты и |S11|^2, log10 только для крайних значений
+    PERF_MEASURE("GraphRenderer::calculateBounds");
+    const auto extents = measurement.size() > parallelBoundsThreshold
+        ? BoundsKernel::computeParallel(measurement.frequencies(), measurement.realParts(), measurement.imagParts())
+        : BoundsKernel::compute(measurement.frequencies(), measurement.realParts(), measurement.imagParts());
     
-    if (data.size() > 500) {
-        auto freqRange = std::minmax_element(
-            std::execution::par_unseq,
-            data.begin(), data.end(),
-            [](const auto& a, const auto& b) { return a.frequency < b.frequency; }
-        );
-        
-        bounds.minFreq = freqRange.first->frequency;
-        bounds.maxFreq = freqRange.second->frequency;
-        
-        std::vector<double> magnitudes(data.size());
-        std::transform(
-            std::execution::par_unseq,
-            data.begin(), data.end(),
-            magnitudes.begin(),
-            [](const auto& point) { return calculateLogMag(point.s11); }
-        );
-        
-        auto magRange = std::minmax_element(
-            std::execution::par_unseq,
-            magnitudes.begin(), magnitudes.end()
-        );
-        
-        bounds.minMag = *magRange.first;
-        bounds.maxMag = *magRange.second;
-    } else {
-        bounds.minFreq = bounds.maxFreq = data[0].frequency;
-        const double firstMag = calculateLogMag(data[0].s11);
-        bounds.minMag = bounds.maxMag = firstMag;
-        
-        for (const auto& point : data) {
-            bounds.minFreq = std::min(bounds.minFreq, point.frequency);
-            bounds.maxFreq = std::max(bounds.maxFreq, point.frequency);
-            
-            const double logMag = calculateLogMag(point.s11);
-            bounds.minMag = std::min(bounds.minMag, logMag);
-            bounds.maxMag = std::max(bounds.maxMag, logMag);
+    bounds.minFreq = extents.minFreq;
+    bounds.maxFreq = extents.maxFreq;
+    bounds.minMag = extents.minMagDb();
+    bounds.maxMag = extents.maxMagDb();
+    
+    addPadding(bounds);
+    
+    return bounds;
+}
+
+GraphRenderer::GraphBounds GraphRenderer::calculateBounds(const Measurement& measurement, const LodPyramid& lod) {
+    if (!lod.isValid() || lod.pointCount() != measurement.size()) {
+        return calculateBounds(measurement);
+    }
+    
+    return calculateBounds(lod);
+}
+
+GraphRenderer::GraphBounds GraphRenderer::calculateBounds(const LodPyramid& lod) {
+    if (!lod.isValid()) {
+        return GraphBounds{};
+    }
+    
+    // Данные отсортированы по частоте, поэтому крайние частоты — первая и последняя точки корня
+    const auto& root = lod.root();
+    GraphBounds bounds{root.first.frequency, root.last.frequency, root.min.value, root.max.value};
+    addPadding(bounds);
+    return bounds;
+}
+
+GraphRenderer::GraphBounds GraphRenderer::calculateBounds(std::span<const TracePart> parts) {
+    if (parts.size() == 1) {
+        return calculateBounds(*parts[0].measurement, *parts[0].lod);
+    }
+    
+    // У кусков слежения за файлом пирамида есть всегда: крайние значения — в корнях
+    GraphBounds bounds{};
+    bool found = false;
+    for (const TracePart& part : parts) {
+        if (!part.lod->isValid()) {
+            continue;
         }
+        const auto& root = part.lod->root();
+        if (!found) {
+            bounds = {root.first.frequency, root.last.frequency, root.min.value, root.max.value};
+            found = true;
+            continue;
+        }
+        bounds.minFreq = std::min(bounds.minFreq, root.first.frequency);
+        bounds.maxFreq = std::max(bounds.maxFreq, root.last.frequency);
+        bounds.minMag = std::min(bounds.minMag, root.min.value);
+        bounds.maxMag = std::max(bounds.maxMag, root.max.value);
     }
     
-    constexpr double freqPadding = 0.05;
-    constexpr double magPadding = 0.1;
+    if (found) {
+        addPadding(bounds);
+    }
+    return bounds;
+}
+
+GraphRenderer::GraphBounds GraphRenderer::applyZoom(const GraphBounds& dataBounds, const ZoomParams& zoom) {
+    if (zoom.isActive && zoom.freqMin < zoom.freqMax && zoom.magMin < zoom.magMax) {
+        return GraphBounds{zoom.freqMin, zoom.freqMax, zoom.magMin, zoom.magMax};
+    }
+    return dataBounds;
+}
+
+GraphRenderer::GraphBounds GraphRenderer::autoScaleBounds(const Measurement& measurement, const LodPyramid& lod,
+                                                          double freqMin, double freqMax) {
+    PERF_MEASURE("GraphRenderer::autoScaleBounds");
     
-    const double freqRange = bounds.maxFreq - bounds.minFreq;
-    const double magRange = bounds.maxMag - bounds.minMag;
+    GraphBounds bounds{freqMin, freqMax, 0.0, 0.0};
+    const auto range = magnitudeRange(measurement, lod, freqMin, freqMax);
+    if (!range.isValid()) {
+        return bounds;
+    }
     
-    bounds.minFreq -= freqRange * freqPadding;
-    bounds.maxFreq += freqRange * freqPadding;
-    bounds.minMag -= magRange * magPadding;
-    bounds.maxMag += magRange * magPadding;
+    fitMagnitudes(bounds, range.min, range.max);
+    return bounds;
+}
+
+GraphRenderer::GraphBounds GraphRenderer::autoScaleBounds(std::span<const TracePart> parts,
+                                                          double freqMin, double freqMax) {
+    if (parts.size() == 1) {
+        return autoScaleBounds(*parts[0].measurement, *parts[0].lod, freqMin, freqMax);
+    }
+    PERF_MEASURE("GraphRenderer::autoScaleBounds");
+    
+    GraphBounds bounds{freqMin, freqMax, 0.0, 0.0};
+    LodPyramid::ValueRange range;
+    // Крайние точки соседних кусков: по ним идет линия, если окно попало между кусками
+    LodPyramid::ValueRange neighbours;
+    bool rightFound = false;
+    
+    for (const TracePart& part : parts) {
+        if (part.lod->isValid()) {
+            const auto& root = part.lod->root();
+            if (root.last.frequency < freqMin) {
+                neighbours.min = neighbours.max = root.last.value;
+                continue;
+            }
+            if (root.first.frequency > freqMax) {
+                if (!rightFound) {
+                    neighbours.min = std::min(neighbours.min, root.first.value);
+                    neighbours.max = std::max(neighbours.max, root.first.value);
+                    rightFound = true;
+                }
+                continue;
+            }
+        }
+        const auto partRange = magnitudeRange(*part.measurement, *part.lod, freqMin, freqMax);
+        range.min = std::min(range.min, partRange.min);
+        range.max = std::max(range.max, partRange.max);
+    }
+    
+    if (!range.isValid()) {
+        range = neighbours;
+    }
+    if (!range.isValid()) {
+        return bounds;
+    }
     
+    fitMagnitudes(bounds, range.min, range.max);
+    return bounds;
+}
+
+GraphRenderer::GraphBounds GraphRenderer::calculateBounds(const SweepStatistics::Envelope& envelope) {
+    if (envelope.empty()) {
+        return GraphBounds{};
+    }
+    
+    GraphBounds bounds{envelope.frequency.front(), envelope.frequency.back(), envelope.minValue, envelope.maxValue};
+    addPadding(bounds);
+    return bounds;
+}
+
+GraphRenderer::GraphBounds GraphRenderer::autoScaleBounds(const SweepStatistics::Envelope& envelope,
+                                                          double freqMin, double freqMax) {
+    GraphBounds bounds{freqMin, freqMax, 0.0, 0.0};
+    
+    const auto [low, high] = envelope.range(freqMin, freqMax);
+    if (low <= high) {
+        fitMagnitudes(bounds, low, high);
+    }
     return bounds;
 }
 
 double GraphRenderer::calculateLogMag(const std::complex<double>& s11) noexcept {
-    const double magnitude = std::abs(s11);
-    return 20.0 * std::log10(magnitude);
+    return logMagnitudeDb(s11.real(), s11.imag());
 }
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Measurement.h"
+#include "LodPyramid.h"
+#include "SweepStatistics.h"
+#include <span>
 #include <QImage>
 #include <QPainter>
 
@@ -19,6 +22,13 @@ public:
         double minMag, maxMag;
     };
 
+    // Кусок трассы: точки и пирамида по ним. Куски одной трассы (снимок слежения
+    // за файлом) идут подряд по возрастанию частоты, у каждого своя пирамида
+    struct TracePart {
+        const Measurement* measurement = nullptr;
+        const LodPyramid* lod = nullptr;
+    };
+    
     struct PixelPoint {
         QPointF point;
         double logMag;
@@ -26,5 +36,21 @@ public:
     
     static GraphBounds calculateBounds(const Measurement& measurement);
     static GraphBounds calculateBounds(const Measurement& measurement, const ZoomParams& zoom);
+    // Границы всех данных без зума; при наличии пирамиды — O(1) по ее корню
+    static GraphBounds calculateBounds(const Measurement& measurement, const LodPyramid& lod);
+    // Границы по корню пирамиды (в том числе огрубленной), O(1)
+    static GraphBounds calculateBounds(const LodPyramid& lod);
+    // Границы трассы из кусков: по корням их пирамид, O(число кусков)
+    static GraphBounds calculateBounds(std::span<const TracePart> parts);
+    // Границы с учетом зума поверх заранее посчитанных границ данных
+    static GraphBounds applyZoom(const GraphBounds& dataBounds, const ZoomParams& zoom);
+    // Частота — окно [freqMin, freqMax], |S11| — по точкам в окне с отступом, O(log n)
+    static GraphBounds autoScaleBounds(const Measurement& measurement, const LodPyramid& lod,
+                                       double freqMin, double freqMax);
+    // То же по кускам трассы; окно между кусками — по крайним точкам соседних кусков
+    static GraphBounds autoScaleBounds(std::span<const TracePart> parts, double freqMin, double freqMax);
+    // Огибающая статистики: границы O(1), автомасштаб по min/max в окне
+    static GraphBounds calculateBounds(const SweepStatistics::Envelope& envelope);
+    static GraphBounds autoScaleBounds(const SweepStatistics::Envelope& envelope, double freqMin, double freqMax);
     static double calculateLogMag(const std::complex<double>& s11) noexcept;
 };
@@ -1,21 +1,36 @@
 #include "GraphWidget.h"
+#include "PlotPainter.h"
 #include "PerformanceUtils.h"
+#include <QElapsedTimer>
 #include <QFont>
 #include <QPen>
-#include <QPainterPath>
+#include <QQuickWindow>
+#include <QtConcurrent/QtConcurrent>
 #include <algorithm>
 #include <mutex>
+#include <utility>
+#include <vector>
 #include <cmath>
 
 GraphWidget::GraphWidget(QQuickItem *parent)
-    : QQuickPaintedItem(parent) {
+    : QQuickPaintedItem(parent)
+    , m_renderWatcher(new QFutureWatcher<RenderedFrame>(this))
+    , m_layers(std::make_shared<PlotLayers>()) {
     setAcceptedMouseButtons(Qt::LeftButton);
     setFlag(ItemHasContents, true);
     setAntialiasing(true);
+    
+    connect(m_renderWatcher, &QFutureWatcher<RenderedFrame>::finished, this, &GraphWidget::onRenderFinished);
 }
 
 void GraphWidget::paint(QPainter *painter) {
-    //PERF_MEASURE("GraphWidget::paint");
+    PERF_MEASURE("GraphWidget::paint");
+    
+    const bool measure = m_metricsEnabled.load(std::memory_order_relaxed);
+    QElapsedTimer paintTimer;
+    if (measure) {
+        paintTimer.start();
+    }
     
     const int width = static_cast<int>(this->width());
     const int height = static_cast<int>(this->height());
@@ -24,133 +39,99 @@ void GraphWidget::paint(QPainter *painter) {
     
     painter->fillRect(0, 0, width, height, Qt::white);
     
-    if (m_isLoading.load(std::memory_order_relaxed)) {
-        drawLoadingOverlay(painter);
-        return;
-    }
-    
-    std::shared_lock lock(m_dataMutex);
-    
-    if (m_measurement.empty()) {
-        lock.unlock();
-        drawEmptyState(painter);
+    // Во время потоковой загрузки вместо заставки рисуется предпросмотр
+    if (!m_hasData.load(std::memory_order_relaxed)) {
+        if (m_isLoading.load(std::memory_order_relaxed)) {
+            drawLoadingOverlay(painter);
+        } else {
+            drawEmptyState(painter);
+        }
         return;
     }
     
-    constexpr int margin = 60;
-    const int plotWidth = width - 2 * margin;
-    const int plotHeight = height - 2 * margin;
-    
-    if (plotWidth <= 0 || plotHeight <= 0) return;
-    
-    const auto bounds = GraphRenderer::calculateBounds(m_measurement, m_zoomParams);
-    const double freqRange = bounds.maxFreq - bounds.minFreq;
-    const double magRange = bounds.maxMag - bounds.minMag;
-    
-    if (freqRange <= 0 || magRange <= 0) return;
-    
-    painter->setRenderHint(QPainter::Antialiasing);
-    
-    // Отрисовка сетки
-    const QPen gridPen(Qt::lightGray, 1, Qt::DotLine);
-    painter->setPen(gridPen);
-    
-    // X
-    for (int i = 1; i < 10; ++i) {
-        const int x = margin + i * plotWidth / 10;
-        painter->drawLine(x, margin, x, height - margin);
+    QImage frame;
+    double renderMs = 0.0;
+    {
+        std::lock_guard lock(m_frameMutex);
+        frame = m_frame;
+        // Растеризация кадра входит только в первый его вывод
+        renderMs = std::exchange(m_frameRenderMs, 0.0);
     }
     
-    // Y
-    for (int i = 1; i < 10; ++i) {
-        const int y = margin + i * plotHeight / 10;
-        painter->drawLine(margin, y, width - margin, y);
+    // Пока новый кадр считается, растягиваем предыдущий под текущий размер
+    if (!frame.isNull()) {
+        painter->drawImage(QRectF(0, 0, width, height), frame);
     }
     
-    // Отрисовка осей
-    const QPen axisPen(Qt::black, 2);
-    painter->setPen(axisPen);
-    painter->drawLine(margin, height - margin, width - margin, height - margin); // X
-    painter->drawLine(margin, margin, margin, height - margin); // Y
-    
-    // Подпись осей
-    painter->setPen(Qt::black);
-    QFont font = painter->font();
-    font.setPointSize(10);
-    painter->setFont(font);
-    
-    painter->drawText(width/2 - 30, height - 10, "Frequency (Hz)");
-    
-    painter->save();
-    painter->translate(15, height/2);
-    painter->rotate(-90);
-    painter->drawText(-40, 0, "|S11| (dB)");
-    painter->restore();
-    
-    // Подпись значений на осях
-    constexpr int numTicks = 5;
-    const double freqStep = freqRange / numTicks;
-    const double magStep = magRange / numTicks;
-    
-    // X
-    for (int i = 0; i <= numTicks; ++i) {
-        const double freq = bounds.minFreq + i * freqStep;
-        const int x = margin + i * plotWidth / numTicks;
-        
-        QString freqStr = formatFrequency(freq);
-        painter->drawText(x - 20, height - margin + 20, freqStr);
+    if (measure) {
+        {
+            std::lock_guard lock(m_frameMutex);
+            m_paintTimings.add(renderMs + static_cast<double>(paintTimer.nsecsElapsed()) / 1e6);
+        }
+        QMetaObject::invokeMethod(this, &GraphWidget::paintStatsChanged, Qt::QueuedConnection);
     }
+}
+
+void GraphWidget::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) {
+    QQuickPaintedItem::geometryChange(newGeometry, oldGeometry);
     
-    // Y
-    for (int i = 0; i <= numTicks; ++i) {
-        const double mag = bounds.minMag + i * magStep;
-        const int y = height - margin - i * plotHeight / numTicks;
-        
-        const QString magStr = QString::number(mag, 'f', 1);
-        painter->drawText(5, y + 5, magStr);
+    if (newGeometry.size() != oldGeometry.size()) {
+        requestFrame();
     }
+}
+
+// Хэндлеры
+
+void GraphWidget::setSnapshot(MeasurementSnapshot::Ptr snapshot) {
+    m_snapshot = std::move(snapshot);
     
-    // Отрисовка графика
-    drawDataPoints(painter, bounds, width, height, margin);
+    setHasData(hasTraces());
+    requestFrame();
+}
+
+void GraphWidget::setOverlays(TraceSet::Ptr overlays) {
+    m_overlays = std::move(overlays);
     
-    lock.unlock();
+    setHasData(hasTraces());
+    requestFrame();
 }
 
-// Хэндлеры
+void GraphWidget::setEnvelope(SweepStatistics::EnvelopePtr envelope) {
+    m_envelope = std::move(envelope);
+    
+    setHasData(hasTraces());
+    requestFrame();
+}
 
-void GraphWidget::updateMeasurement(const Measurement& measurement) {
-    {
-        std::unique_lock lock(m_dataMutex);
-        m_measurement = measurement;
-    }
+void GraphWidget::setLimitMask(LimitMask::Ptr mask, LimitMask::ResultPtr result) {
+    m_mask = std::move(mask);
+    m_maskResult = std::move(result);
+    ++m_maskVersion;
     
-    setHasData(!measurement.empty());
-    update();
+    requestFrame();
+}
+
+bool GraphWidget::hasTraces() const noexcept {
+    return (m_snapshot && !m_snapshot->empty()) || (m_overlays && !m_overlays->empty()) ||
+           (m_envelope && !m_envelope->empty());
 }
 
 void GraphWidget::setZoomParams(const GraphRenderer::ZoomParams& zoom) {
-    bool wasActive;
-    {
-        std::unique_lock lock(m_dataMutex);
-        wasActive = m_zoomParams.isActive;
-        m_zoomParams = zoom;
-    }
+    const bool wasActive = m_zoomParams.isActive;
+    m_zoomParams = zoom;
     
     if (wasActive != zoom.isActive) {
         emit isZoomedChanged();
     }
     
-    update();
+    requestFrame();
 }
 
 void GraphWidget::resetZoom() {
-    {
-        std::unique_lock lock(m_dataMutex);
-        m_zoomParams.isActive = false;
-    }
+    m_zoomParams.isActive = false;
     
     emit isZoomedChanged();
-    update();
+    requestFrame();
 }
 
 void GraphWidget::setIsLoading(bool loading) {
@@ -181,6 +162,36 @@ void GraphWidget::setEmptyText(const QString& text) {
     }
 }
 
+void GraphWidget::setMetricsEnabled(bool enabled) {
+    if (m_metricsEnabled.exchange(enabled) == enabled) {
+        return;
+    }
+    
+    // Окно начинается заново, чтобы не смешивать с замерами прошлого включения
+    {
+        std::lock_guard lock(m_frameMutex);
+        m_paintTimings.clear();
+        m_frameRenderMs = 0.0;
+    }
+    emit metricsEnabledChanged();
+    emit paintStatsChanged();
+}
+
+double GraphWidget::lastPaintMs() const {
+    std::lock_guard lock(m_frameMutex);
+    return m_paintTimings.last();
+}
+
+double GraphWidget::paintP50Ms() const {
+    std::lock_guard lock(m_frameMutex);
+    return m_paintTimings.percentile(0.5);
+}
+
+double GraphWidget::paintP99Ms() const {
+    std::lock_guard lock(m_frameMutex);
+    return m_paintTimings.percentile(0.99);
+}
+
 void GraphWidget::setHasData(bool hasData) {
     const bool oldValue = m_hasData.exchange(hasData);
     if (oldValue != hasData) {
@@ -210,100 +221,126 @@ void GraphWidget::drawEmptyState(QPainter *painter) {
     painter->drawText(textRect, Qt::AlignCenter, m_emptyText);
 }
 
+// Растеризация в рабочем потоке
 
-QString GraphWidget::formatFrequency(double freq) const {
-    if (freq >= 1e9) {
-        return QString::number(freq / 1e9, 'f', 1) + "G";   // Гига
-    } else if (freq >= 1e6) {
-        return QString::number(freq / 1e6, 'f', 1) + "M";   // Мега
-    } else if (freq >= 1e3) {
-        return QString::number(freq / 1e3, 'f', 1) + "k";   // Кило
-    } else {
-        return QString::number(freq, 'f', 0);
+void GraphWidget::requestFrame() {
+    ++m_generation;
+    
+    if (!hasTraces()) {
+        {
+            std::lock_guard lock(m_frameMutex);
+            m_frame = QImage();
+        }
+        update();
+        return;
+    }
+    
+    // Одновременно считается не больше одного кадра, остальные запросы схлопываются
+    if (m_renderInFlight) {
+        m_renderQueued = true;
+        return;
     }
+    startRender();
 }
 
-void GraphWidget::drawDataPoints(QPainter *painter, const GraphRenderer::GraphBounds& bounds, 
-                                int width, int height, int margin) {
-    const QPen dataPen(Qt::blue, 2);
-    painter->setPen(dataPen);
-
-    const double freqRange = bounds.maxFreq - bounds.minFreq;
-    const double magRange = bounds.maxMag - bounds.minMag;
-    const double plotWidth = width - 2 * margin;
-    const double plotHeight = height - 2 * margin;
-    
-    const double invFreqRange = 1.0 / freqRange;
-    const double invMagRange = 1.0 / magRange;
-        
-    // Отрисовка графика с помощью кривой QPainterPath
-    QPainterPath path;
-    bool firstPoint = true;
+void GraphWidget::startRender() {
+    const QSize size(static_cast<int>(width()), static_cast<int>(height()));
+    if (size.isEmpty()) {
+        return;
+    }
     
-    const size_t dataSize = m_measurement.data.size();
-    // Аппроксимация, если точек много
-    if (dataSize > 1000) {
-        const size_t step = std::max(size_t(1), dataSize / 2000);
+    const qreal devicePixelRatio = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+    const auto snapshot = m_snapshot;
+    const auto overlays = m_overlays;
+    const auto envelope = m_envelope;
+    const auto mask = m_mask;
+    const auto maskResult = m_maskResult;
+    const quint64 maskVersion = m_maskVersion;
+    const auto zoom = m_zoomParams;
+    const quint64 generation = m_generation;
+    const bool measure = m_metricsEnabled.load(std::memory_order_relaxed);
+    
+    m_renderInFlight = true;
+    m_renderQueued = false;
+    
+    QThreadPool* pool = m_threadPool ? m_threadPool : QThreadPool::globalInstance();
+    m_renderWatcher->setFuture(QtConcurrent::run(pool, [layers = m_layers, snapshot, overlays, envelope, mask, maskResult,
+                                                        maskVersion, zoom, size, devicePixelRatio, generation, measure]() {
+        PERF_MEASURE("GraphWidget::renderFrame");
+        QElapsedTimer renderTimer;
+        if (measure) {
+            renderTimer.start();
+        }
+        const auto bounds = GraphRenderer::applyZoom(TraceSet::combinedBounds(snapshot, overlays, envelope), zoom);
         
-        for (size_t i = 0; i < dataSize; i += step) {
-            const auto& point = m_measurement.data[i];
-            const double logMag = GraphRenderer::calculateLogMag(point.s11);
-            
-            const double x = margin + (point.frequency - bounds.minFreq) * invFreqRange * plotWidth;
-            const double y = height - margin - (logMag - bounds.minMag) * invMagRange * plotHeight;
-            
-            // Сжатие, если одна из точек вышла за границы
-            const double clampedX = std::clamp(x, -1000.0, static_cast<double>(width + 1000));
-            const double clampedY = std::clamp(y, -1000.0, static_cast<double>(height + 1000));
-            
-            const QPointF pixelPoint(clampedX, clampedY);
-            
-            if (firstPoint) {
-                path.moveTo(pixelPoint);
-                firstPoint = false;
-            } else {
-                path.lineTo(pixelPoint);
+        // Файл больше памяти: узкое окно дочитывается из файла в полном разрешении.
+        // Источник помнит последнее окно, поэтому кадры без смены окна файл не читают
+        const int columns = std::max(1, size.width() - 2 * PlotPainter::margin);
+        const auto readWindow = [&bounds, columns](const MeasurementSnapshot& trace) -> OutOfCoreSweep::WindowPtr {
+            if (!trace.outOfCore()) {
+                return nullptr;
             }
+            return trace.outOfCore()->renderWindow(bounds.minFreq, bounds.maxFreq, columns);
+        };
+        
+        // Окно в полном разрешении рисуется одним куском вместо пирамиды источника
+        const auto traceParts = [](const MeasurementSnapshot& trace, const OutOfCoreSweep::WindowPtr& window) {
+            return window ? std::vector<GraphRenderer::TracePart>{{&window->measurement, &window->lod}} : trace.parts();
+        };
+        
+        PlotLayers::Inputs inputs;
+        OutOfCoreSweep::WindowPtr window;
+        if (snapshot && !snapshot->empty()) {
+            window = readWindow(*snapshot);
+            inputs.trace = traceParts(*snapshot, window);
+            inputs.dataVersion = snapshot->version();
         }
-    } else {
-        for (const auto& point : m_measurement.data) {
-            const double logMag = GraphRenderer::calculateLogMag(point.s11);
-            
-            const double x = margin + (point.frequency - bounds.minFreq) * invFreqRange * plotWidth;
-            const double y = height - margin - (logMag - bounds.minMag) * invMagRange * plotHeight;
-            
-           // Сжатие, если одна из точек вышла за границы
-            const double clampedX = std::clamp(x, -1000.0, static_cast<double>(width + 1000));
-            const double clampedY = std::clamp(y, -1000.0, static_cast<double>(height + 1000));
-            
-            const QPointF pixelPoint(clampedX, clampedY);
-            
-            if (firstPoint) {
-                path.moveTo(pixelPoint);
-                firstPoint = false;
-            } else {
-                path.lineTo(pixelPoint);
+        
+        // Окна наложенных трасс живут до конца кадра
+        std::vector<OutOfCoreSweep::WindowPtr> overlayWindows;
+        if (overlays) {
+            overlayWindows.reserve(overlays->size());
+            for (const auto& trace : overlays->traces()) {
+                const auto& overlayWindow = overlayWindows.emplace_back(readWindow(*trace.snapshot));
+                inputs.overlays.push_back({traceParts(*trace.snapshot, overlayWindow),
+                                           PlotPainter::traceColor(trace.colorIndex)});
             }
+            inputs.overlayVersion = overlays->version();
         }
-    }
-    painter->drawPath(path);
-    
-    // Отрисовка точек
-    if (dataSize < 500 || m_zoomParams.isActive) {
-        painter->setBrush(Qt::blue);
-        const size_t step = m_zoomParams.isActive ? 1 : std::max(size_t(1), dataSize / 500);
         
-        for (size_t i = 0; i < dataSize; i += step) {
-            const auto& point = m_measurement.data[i];
-            const double logMag = GraphRenderer::calculateLogMag(point.s11);
-            
-            const double x = margin + (point.frequency - bounds.minFreq) * invFreqRange * plotWidth;
-            const double y = height - margin - (logMag - bounds.minMag) * invMagRange * plotHeight;
-            
-            if (x >= margin && x <= width - margin && y >= margin && y <= height - margin) {
-                const QPointF pixelPoint(x, y);
-                painter->drawEllipse(pixelPoint, 2, 2);
-            }
+        if (envelope && !envelope->empty()) {
+            inputs.envelope = envelope.get();
+        }
+        inputs.mask = mask.get();
+        inputs.maskResult = maskResult.get();
+        inputs.maskVersion = maskVersion;
+        
+        inputs.bounds = bounds;
+        inputs.showAllPoints = zoom.isActive;
+        inputs.size = size;
+        inputs.devicePixelRatio = devicePixelRatio;
+        QImage image = layers->compose(inputs);
+        return RenderedFrame{std::move(image), generation, measure ? static_cast<double>(renderTimer.nsecsElapsed()) / 1e6 : 0.0};
+    }));
+}
+
+void GraphWidget::onRenderFinished() {
+    m_renderInFlight = false;
+    
+    RenderedFrame frame = m_renderWatcher->result();
+    emit layerStatsChanged();
+    
+    if (frame.generation == m_generation) {
+        {
+            std::lock_guard lock(m_frameMutex);
+            m_frame = std::move(frame.image);
+            m_frameRenderMs = frame.renderMs;
         }
+        update();
+    }
+    
+    // Устаревший кадр отброшен — считаем актуальный
+    if (m_renderQueued || frame.generation != m_generation) {
+        startRender();
     }
 }
@@ -4,10 +4,18 @@
 #include <QPainter>
 #include <QMouseEvent>
 #include <QPointF>
+#include <QImage>
+#include <QThreadPool>
+#include <QFutureWatcher>
 #include <atomic>
-#include <shared_mutex>
-#include "Measurement.h"
+#include <memory>
+#include <mutex>
+#include "MeasurementSnapshot.h"
+#include "TraceSet.h"
+#include "LimitMask.h"
 #include "GraphRenderer.h"
+#include "PlotLayers.h"
+#include "FrameTimings.h"
 
 class GraphWidget : public QQuickPaintedItem {
     Q_OBJECT
@@ -16,6 +24,13 @@ class GraphWidget : public QQuickPaintedItem {
     Q_PROPERTY(QString loadingText READ loadingText WRITE setLoadingText NOTIFY loadingTextChanged)
     Q_PROPERTY(QString emptyText READ emptyText WRITE setEmptyText NOTIFY emptyTextChanged)
     Q_PROPERTY(bool isZoomed READ isZoomed NOTIFY isZoomedChanged)
+    Q_PROPERTY(int gridLayerRenders READ gridLayerRenders NOTIFY layerStatsChanged)
+    Q_PROPERTY(int axesLayerRenders READ axesLayerRenders NOTIFY layerStatsChanged)
+    Q_PROPERTY(int traceLayerRenders READ traceLayerRenders NOTIFY layerStatsChanged)
+    Q_PROPERTY(bool metricsEnabled READ metricsEnabled WRITE setMetricsEnabled NOTIFY metricsEnabledChanged)
+    Q_PROPERTY(double lastPaintMs READ lastPaintMs NOTIFY paintStatsChanged)
+    Q_PROPERTY(double paintP50Ms READ paintP50Ms NOTIFY paintStatsChanged)
+    Q_PROPERTY(double paintP99Ms READ paintP99Ms NOTIFY paintStatsChanged)
 
 public:
     explicit GraphWidget(QQuickItem *parent = nullptr);
@@ -25,13 +40,33 @@ public:
     QString loadingText() const { return m_loadingText; }
     QString emptyText() const { return m_emptyText; }
     bool isZoomed() const { return m_zoomParams.isActive; }
+    int gridLayerRenders() const { return static_cast<int>(m_layers->gridRenders()); }
+    int axesLayerRenders() const { return static_cast<int>(m_layers->axesRenders()); }
+    int traceLayerRenders() const { return static_cast<int>(m_layers->traceRenders()); }
+    
+    // Время кадра — растеризация в рабочем потоке плюс вывод в paint();
+    // замеряется, только пока включены метрики
+    bool metricsEnabled() const { return m_metricsEnabled.load(std::memory_order_relaxed); }
+    double lastPaintMs() const;
+    double paintP50Ms() const;
+    double paintP99Ms() const;
+    void setMetricsEnabled(bool enabled);
     
     void setIsLoading(bool loading);
     void setLoadingText(const QString& text);
     void setEmptyText(const QString& text);
+    
+    // Пул для растеризации кадров; по умолчанию глобальный
+    void setThreadPool(QThreadPool* pool) { m_threadPool = pool; }
 
 public slots:
-    void updateMeasurement(const Measurement& measurement);
+    void setSnapshot(MeasurementSnapshot::Ptr snapshot);
+    // Трассы других файлов поверх основной; nullptr — без наложения
+    void setOverlays(TraceSet::Ptr overlays);
+    // Полоса статистики по свипам под трассами; nullptr — без нее
+    void setEnvelope(SweepStatistics::EnvelopePtr envelope);
+    // Маска допуска и результат проверки основной трассы; nullptr — без маски или без проверки
+    void setLimitMask(LimitMask::Ptr mask, LimitMask::ResultPtr result);
     void setZoomParams(const GraphRenderer::ZoomParams& zoom);
     void resetZoom();
 
@@ -41,21 +76,58 @@ signals:
     void loadingTextChanged();
     void emptyTextChanged();
     void isZoomedChanged();
+    void layerStatsChanged();
+    void metricsEnabledChanged();
+    void paintStatsChanged();
 
 protected:
     void paint(QPainter *painter) override;
+    void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
 
 private:
+    struct RenderedFrame {
+        QImage image;
+        quint64 generation = 0;
+        double renderMs = 0.0;
+    };
+    
     void setHasData(bool hasData);
     void drawLoadingOverlay(QPainter *painter);
     void drawEmptyState(QPainter *painter);
-    void drawDataPoints(QPainter *painter, const GraphRenderer::GraphBounds& bounds,
-                       int width, int height, int margin);
-    QString formatFrequency(double freq) const;
     
-    Measurement m_measurement;
+    // Поколение растет при любом изменении данных, зума или размера;
+    // кадры старых поколений отбрасываются
+    void requestFrame();
+    void startRender();
+    void onRenderFinished();
+    [[nodiscard]] bool hasTraces() const noexcept;
+    
+    // Тот же снимок, что и у Backend; рабочий поток держит его на время кадра
+    MeasurementSnapshot::Ptr m_snapshot;
+    TraceSet::Ptr m_overlays;
+    SweepStatistics::EnvelopePtr m_envelope;
+    LimitMask::Ptr m_mask;
+    LimitMask::ResultPtr m_maskResult;
+    quint64 m_maskVersion = 0;
     GraphRenderer::ZoomParams m_zoomParams;
-    mutable std::shared_mutex m_dataMutex;
+    
+    QThreadPool* m_threadPool = nullptr;
+    QFutureWatcher<RenderedFrame>* m_renderWatcher;
+    quint64 m_generation = 0;
+    bool m_renderInFlight = false;
+    bool m_renderQueued = false;
+    // Слои живут между кадрами; одновременно с ними работает только один рендер
+    std::shared_ptr<PlotLayers> m_layers;
+    
+    // Последний готовый кадр; paint() только копирует его на экран
+    QImage m_frame;
+    double m_frameRenderMs = 0.0;
+    mutable std::mutex m_frameMutex;
+    
+    // Выключено — paint() и рендер не читают часы.
+    // paint() может идти в потоке рендера сцены, окно — под m_frameMutex
+    std::atomic<bool> m_metricsEnabled{false};
+    FrameTimings m_paintTimings;
     
     std::atomic<bool> m_hasData{false};
     std::atomic<bool> m_isLoading{false};
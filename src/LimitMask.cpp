@@ -0,0 +1,334 @@
+#include "LimitMask.h"
+#include "MappedFile.h"
+#include "SimdScanner.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+
+namespace {
+
+constexpr std::string_view trimLine(std::string_view line) noexcept {
+    constexpr auto whitespace = " \t\r\n";
+    const auto start = line.find_first_not_of(whitespace);
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    return line.substr(start, line.find_last_not_of(whitespace) - start + 1);
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+bool parseNumber(std::string_view text, double& value) noexcept {
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc{} && ptr == text.data() + text.size() && std::isfinite(value);
+}
+
+// Множитель до Hz; 0 — неизвестная единица
+double unitScale(std::string_view unit) noexcept {
+    if (equalsIgnoreCase(unit, "Hz")) {
+        return 1.0;
+    }
+    if (equalsIgnoreCase(unit, "kHz")) {
+        return 1e3;
+    }
+    if (equalsIgnoreCase(unit, "MHz")) {
+        return 1e6;
+    }
+    if (equalsIgnoreCase(unit, "GHz")) {
+        return 1e9;
+    }
+    return 0.0;
+}
+
+// Худшая точка отрезка и число точек за границей
+struct SegmentScan {
+    size_t worstIndex = 0;
+    size_t failed = 0;
+};
+
+// excess(i) > 0 — точка за границей; чем больше, тем хуже. Цикл без ветвлений:
+// худшая точка выбирается условным присваиванием
+template<typename Excess>
+SegmentScan scan(size_t begin, size_t end, Excess excess) {
+    SegmentScan result{begin, 0};
+    double worst = -std::numeric_limits<double>::infinity();
+    for (size_t i = begin; i < end; ++i) {
+        const double value = excess(i);
+        const bool worse = value > worst;
+        worst = worse ? value : worst;
+        result.worstIndex = worse ? i : result.worstIndex;
+        result.failed += value > 0.0;
+    }
+    return result;
+}
+
+} // namespace
+
+double LimitMask::Segment::limitAt(double frequency) const noexcept {
+    const double span = stopFrequency - startFrequency;
+    if (span <= 0.0) {
+        return startLimitDb;
+    }
+    return startLimitDb + (stopLimitDb - startLimitDb) * (frequency - startFrequency) / span;
+}
+
+LimitMask::LimitMask(std::vector<Segment> segments)
+    : m_segments(std::move(segments)) {
+    if (m_segments.empty()) {
+        return;
+    }
+    m_minFrequency = m_segments.front().startFrequency;
+    m_maxFrequency = m_segments.front().stopFrequency;
+    for (const Segment& segment : m_segments) {
+        m_minFrequency = std::min(m_minFrequency, segment.startFrequency);
+        m_maxFrequency = std::max(m_maxFrequency, segment.stopFrequency);
+    }
+}
+
+LimitMask::LoadExpected LimitMask::load(const std::filesystem::path& filePath) {
+    MappedFile file;
+    if (!file.open(filePath)) {
+        return LoadError{0, "cannot open " + filePath.string()};
+    }
+    return parse(file.view());
+}
+
+LimitMask::LoadExpected LimitMask::parse(std::string_view text) {
+    std::vector<Segment> segments;
+    double scale = 1.0;
+    size_t lineNumber = 0;
+    
+    const char* const end = text.data() + text.size();
+    for (const char* lineStart = text.data(); lineStart < end; ) {
+        const char* lineEnd = SimdScanner::findNewline(lineStart, end);
+        const auto line = trimLine(std::string_view(lineStart, static_cast<size_t>(lineEnd - lineStart)));
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+        
+        if (line.empty() || line[0] == '!') {
+            continue;
+        }
+        
+        std::array<std::string_view, 6> tokens;
+        const size_t count = SimdScanner::splitFields(line, tokens.data(), tokens.size());
+        
+        // Единицы частот: "# GHz"
+        if (line[0] == '#') {
+            const std::string_view unit = tokens[0].size() > 1 ? tokens[0].substr(1) : count > 1 ? tokens[1] : "";
+            scale = unitScale(unit);
+            if (scale == 0.0) {
+                return LoadError{lineNumber, "unknown frequency unit '" + std::string(unit) + "'"};
+            }
+            continue;
+        }
+        
+        if (count != 4 && count != 5) {
+            return LoadError{lineNumber, "expected: upper|lower F_START F_STOP LIMIT_DB [LIMIT_STOP_DB]"};
+        }
+        
+        Segment segment;
+        if (equalsIgnoreCase(tokens[0], "upper")) {
+            segment.kind = Kind::Upper;
+        } else if (equalsIgnoreCase(tokens[0], "lower")) {
+            segment.kind = Kind::Lower;
+        } else {
+            return LoadError{lineNumber, "segment type must be 'upper' or 'lower'"};
+        }
+        
+        if (!parseNumber(tokens[1], segment.startFrequency) || !parseNumber(tokens[2], segment.stopFrequency) ||
+            !parseNumber(tokens[3], segment.startLimitDb)) {
+            return LoadError{lineNumber, "invalid number"};
+        }
+        segment.stopLimitDb = segment.startLimitDb;
+        if (count == 5 && !parseNumber(tokens[4], segment.stopLimitDb)) {
+            return LoadError{lineNumber, "invalid number"};
+        }
+        if (segment.startFrequency > segment.stopFrequency) {
+            return LoadError{lineNumber, "F_START is greater than F_STOP"};
+        }
+        
+        segment.startFrequency *= scale;
+        segment.stopFrequency *= scale;
+        segments.push_back(segment);
+    }
+    
+    if (segments.empty()) {
+        return LoadError{0, "mask has no segments"};
+    }
+    return LimitMask(std::move(segments));
+}
+
+LimitMask::Result LimitMask::evaluate(const Measurement& measurement) const {
+    if (!measurement.isSortedByFrequency()) {
+        Measurement sorted = measurement;
+        sorted.sortByFrequency();
+        return evaluate(sorted);
+    }
+    return evaluate(measurement.frequencies(), measurement.realParts(), measurement.imagParts());
+}
+
+LimitMask::Result LimitMask::evaluate(std::span<const double> frequency,
+                                      std::span<const double> real,
+                                      std::span<const double> imag) const {
+    PERF_MEASURE("LimitMask::evaluate");
+    
+    Result result;
+    const size_t n = std::min({frequency.size(), real.size(), imag.size()});
+    if (n == 0 || m_segments.empty()) {
+        result.complete = false;
+        return result;
+    }
+    frequency = frequency.first(n);
+    
+    double worstMargin = std::numeric_limits<double>::infinity();
+    for (size_t s = 0; s < m_segments.size(); ++s) {
+        const Segment& segment = m_segments[s];
+        if (segment.startFrequency < frequency.front() || segment.stopFrequency > frequency.back()) {
+            result.complete = false;
+        }
+        
+        const size_t begin = static_cast<size_t>(
+            std::lower_bound(frequency.begin(), frequency.end(), segment.startFrequency) - frequency.begin());
+        const size_t end = static_cast<size_t>(
+            std::upper_bound(frequency.begin() + begin, frequency.end(), segment.stopFrequency) - frequency.begin());
+        if (begin >= end) {
+            continue;
+        }
+        result.checkedPoints += end - begin;
+        
+        const bool upper = segment.kind == Kind::Upper;
+        const double sign = upper ? 1.0 : -1.0;
+        // Запас в дБ: больше нуля — точка в допуске
+        const auto marginAt = [&](size_t i) {
+            const double magnitude = logMagnitudeDb(real[i], imag[i]);
+            const double limit = segment.limitAt(frequency[i]);
+            return upper ? limit - magnitude : magnitude - limit;
+        };
+        
+        // Постоянная граница сравнивается с |S11|^2 напрямую, наклонная — в дБ
+        const double powerLimit = std::pow(10.0, segment.startLimitDb / 10.0);
+        const auto flatExcess = [&](size_t i) {
+            return sign * (real[i] * real[i] + imag[i] * imag[i] - powerLimit);
+        };
+        const auto slopedExcess = [&](size_t i) { return -marginAt(i); };
+        const SegmentScan segmentScan = segment.isFlat() ? scan(begin, end, flatExcess)
+                                                         : scan(begin, end, slopedExcess);
+        
+        const double margin = marginAt(segmentScan.worstIndex);
+        if (margin < worstMargin) {
+            worstMargin = margin;
+            result.worstFrequency = frequency[segmentScan.worstIndex];
+        }
+        if (segmentScan.failed == 0) {
+            continue;
+        }
+        result.failedPoints += segmentScan.failed;
+        
+        // Нарушения редки: участки собираются вторым проходом только по такому отрезку
+        const auto fails = [&](size_t i) {
+            return (segment.isFlat() ? flatExcess(i) : slopedExcess(i)) > 0.0;
+        };
+        for (size_t i = begin; i < end && result.violations.size() < maxViolations; ) {
+            if (!fails(i)) {
+                ++i;
+                continue;
+            }
+            Violation violation;
+            violation.segment = s;
+            violation.lowFrequency = frequency[i];
+            violation.worstMarginDb = std::numeric_limits<double>::infinity();
+            for (; i < end && fails(i); ++i) {
+                const double pointMargin = marginAt(i);
+                if (pointMargin < violation.worstMarginDb) {
+                    violation.worstMarginDb = pointMargin;
+                    violation.worstFrequency = frequency[i];
+                }
+                violation.highFrequency = frequency[i];
+                ++violation.pointCount;
+            }
+            result.violations.push_back(violation);
+        }
+    }
+    
+    if (result.checkedPoints > 0) {
+        result.worstMarginDb = worstMargin;
+    }
+    return result;
+}
+
+LimitMask::Result LimitMask::evaluate(std::span<const Measurement* const> parts) const {
+    std::vector<const Measurement*> filled;
+    for (const Measurement* part : parts) {
+        if (!part->empty()) {
+            filled.push_back(part);
+        }
+    }
+    if (filled.size() == 1) {
+        return evaluate(*filled.front());
+    }
+    
+    Result result;
+    if (filled.empty() || m_segments.empty()) {
+        result.complete = false;
+        return result;
+    }
+    
+    const double firstFrequency = filled.front()->frequencies().front();
+    const double lastFrequency = filled.back()->frequencies().back();
+    for (const Segment& segment : m_segments) {
+        if (segment.startFrequency < firstFrequency || segment.stopFrequency > lastFrequency) {
+            result.complete = false;
+        }
+    }
+    
+    double worstMargin = std::numeric_limits<double>::infinity();
+    // Нарушения, которые доходят до последней точки предыдущего куска, по номеру отрезка
+    std::vector<size_t> openViolation(m_segments.size(), maxViolations);
+    for (const Measurement* part : filled) {
+        const Result partResult = evaluate(*part);
+        const double partFirst = part->frequencies().front();
+        std::vector<size_t> nextOpen(m_segments.size(), maxViolations);
+        
+        result.checkedPoints += partResult.checkedPoints;
+        result.failedPoints += partResult.failedPoints;
+        if (partResult.checkedPoints > 0 && partResult.worstMarginDb < worstMargin) {
+            worstMargin = partResult.worstMarginDb;
+            result.worstFrequency = partResult.worstFrequency;
+        }
+        
+        for (const Violation& violation : partResult.violations) {
+            size_t index = maxViolations;
+            if (const size_t open = openViolation[violation.segment];
+                open < result.violations.size() && violation.lowFrequency == partFirst) {
+                // Продолжение участка с конца предыдущего куска
+                Violation& merged = result.violations[open];
+                merged.highFrequency = violation.highFrequency;
+                merged.pointCount += violation.pointCount;
+                if (violation.worstMarginDb < merged.worstMarginDb) {
+                    merged.worstMarginDb = violation.worstMarginDb;
+                    merged.worstFrequency = violation.worstFrequency;
+                }
+                index = open;
+            } else if (result.violations.size() < maxViolations) {
+                index = result.violations.size();
+                result.violations.push_back(violation);
+            }
+            if (violation.highFrequency == part->frequencies().back()) {
+                nextOpen[violation.segment] = index;
+            }
+        }
+        openViolation = std::move(nextOpen);
+    }
+    
+    if (result.checkedPoints > 0) {
+        result.worstMarginDb = worstMargin;
+    }
+    return result;
+}
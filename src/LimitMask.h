@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Measurement.h"
+#include <cstddef>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Маска допуска (limit line) для |S11| дБ: отрезки верхней и нижней границы,
+// на каждом граница линейна по частоте. Файл маски — текст, по отрезку на строку:
+//   upper|lower  F_START  F_STOP  LIMIT_DB  [LIMIT_STOP_DB]
+// Без LIMIT_STOP_DB граница на отрезке постоянна. "!" — комментарий,
+// строка "# Hz|kHz|MHz|GHz" задает единицы частот следующих строк (по умолчанию Hz,
+// как у данных .s1p). Пример: |S11| < -15 дБ на 2.4–2.5 ГГц:
+//   # GHz
+//   upper 2.4 2.5 -15
+class LimitMask {
+public:
+    enum class Kind {
+        // |S11| не выше границы
+        Upper,
+        // |S11| не ниже границы
+        Lower
+    };
+    
+    struct Segment {
+        Kind kind = Kind::Upper;
+        double startFrequency = 0.0;
+        double stopFrequency = 0.0;
+        double startLimitDb = 0.0;
+        double stopLimitDb = 0.0;
+        
+        [[nodiscard]] bool isFlat() const noexcept { return startLimitDb == stopLimitDb; }
+        [[nodiscard]] double limitAt(double frequency) const noexcept;
+    };
+    
+    struct LoadError {
+        // Номер строки с 1; 0 — ошибка не в строке (файл не открылся, нет отрезков)
+        size_t line = 0;
+        std::string message;
+    };
+    
+    // Непрерывный участок точек одного отрезка за границей
+    struct Violation {
+        size_t segment = 0;
+        double lowFrequency = 0.0;
+        double highFrequency = 0.0;
+        size_t pointCount = 0;
+        double worstMarginDb = 0.0;
+        double worstFrequency = 0.0;
+    };
+    
+    struct Result {
+        // Запас до ближайшей границы, дБ; меньше нуля — граница нарушена.
+        // NaN — под маску не попала ни одна точка
+        double worstMarginDb = std::numeric_limits<double>::quiet_NaN();
+        double worstFrequency = std::numeric_limits<double>::quiet_NaN();
+        size_t checkedPoints = 0;
+        size_t failedPoints = 0;
+        // Свип покрывает все отрезки маски целиком
+        bool complete = true;
+        // Не больше maxViolations участков; failedPoints считает все точки
+        std::vector<Violation> violations;
+        
+        [[nodiscard]] bool passed() const noexcept { return complete && checkedPoints > 0 && failedPoints == 0; }
+    };
+    
+    using Ptr = std::shared_ptr<const LimitMask>;
+    using ResultPtr = std::shared_ptr<const Result>;
+    using LoadExpected = std::variant<LimitMask, LoadError>;
+    
+    static constexpr size_t maxViolations = 256;
+    
+    LimitMask() = default;
+    explicit LimitMask(std::vector<Segment> segments);
+    
+    [[nodiscard]] static LoadExpected load(const std::filesystem::path& filePath);
+    [[nodiscard]] static LoadExpected parse(std::string_view text);
+    
+    [[nodiscard]] const std::vector<Segment>& segments() const noexcept { return m_segments; }
+    [[nodiscard]] bool empty() const noexcept { return m_segments.empty(); }
+    // Диапазон частот всех отрезков
+    [[nodiscard]] double minFrequency() const noexcept { return m_minFrequency; }
+    [[nodiscard]] double maxFrequency() const noexcept { return m_maxFrequency; }
+    
+    // Неотсортированное измерение проверяется по отсортированной копии
+    [[nodiscard]] Result evaluate(const Measurement& measurement) const;
+    
+    // Частоты по возрастанию. Точки каждого отрезка находятся двоичным поиском;
+    // у постоянной границы сравнение идет по |S11|^2 без логарифма на точку,
+    // log10 берется только для худшей точки и точек нарушений
+    [[nodiscard]] Result evaluate(std::span<const double> frequency,
+                                  std::span<const double> real,
+                                  std::span<const double> imag) const;
+    
+    // Свип из отсортированных кусков, идущих подряд по возрастанию частоты
+    // (снимок слежения за файлом): куски проверяются по отдельности без склейки
+    // столбцов, участок нарушения на стыке кусков сводится в один
+    [[nodiscard]] Result evaluate(std::span<const Measurement* const> parts) const;
+    
+private:
+    std::vector<Segment> m_segments;
+    double m_minFrequency = 0.0;
+    double m_maxFrequency = 0.0;
+};
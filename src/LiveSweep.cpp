@@ -0,0 +1,341 @@
+#include "LiveSweep.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <execution>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Сколько байт сравнивается в начале файла и перед разобранным концом
+constexpr size_t headBytes = 256;
+constexpr size_t seamBytes = 64;
+constexpr size_t maxChunkBytes = 4 * 1024 * 1024;
+// Незавершенная строка длиннее этого при загрузке не ищется: слежение начнется с полного разбора
+constexpr size_t maxPendingBytes = 64 * 1024;
+
+// Байты [offset, offset + count); меньше, если файл успел стать короче
+std::string readRange(std::ifstream& file, size_t offset, size_t count) {
+    std::string buffer(count, '\0');
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(buffer.data(), static_cast<std::streamsize>(count));
+    buffer.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+    return buffer;
+}
+
+// Длина text до конца последней полной строки
+size_t completeLinesLength(std::string_view text) noexcept {
+    const size_t newline = text.rfind('\n');
+    return newline == std::string_view::npos ? 0 : newline + 1;
+}
+
+// Последние не больше count байт text
+std::string lastBytes(std::string_view text, size_t count) {
+    return std::string(text.substr(text.size() - std::min(count, text.size())));
+}
+
+// Дописанные строки обычно короткие и разбираются одним блоком;
+// первое чтение большого файла делится на блоки по строкам и идет параллельно
+S11Parser::ColumnBlock parseLines(std::string_view text) {
+    S11Parser::ColumnBlock result;
+    const auto chunks = S11Parser::splitIntoChunks(text, maxChunkBytes);
+    if (chunks.size() <= 1) {
+        if (!chunks.empty()) {
+            S11Parser::parseChunk(chunks.front(), result);
+        }
+        return result;
+    }
+    
+    std::vector<S11Parser::ColumnBlock> blocks(chunks.size());
+    std::for_each(
+        std::execution::par,
+        blocks.begin(), blocks.end(),
+        [&blocks, &chunks](S11Parser::ColumnBlock& block) {
+            S11Parser::parseChunk(chunks[static_cast<size_t>(&block - blocks.data())], block);
+        }
+    );
+    
+    size_t totalPoints = 0;
+    for (const auto& block : blocks) {
+        totalPoints += block.frequency.size();
+    }
+    result.frequency.reserve(totalPoints);
+    result.real.reserve(totalPoints);
+    result.imag.reserve(totalPoints);
+    for (const auto& block : blocks) {
+        result.frequency.insert(result.frequency.end(), block.frequency.begin(), block.frequency.end());
+        result.real.insert(result.real.end(), block.real.begin(), block.real.end());
+        result.imag.insert(result.imag.end(), block.imag.begin(), block.imag.end());
+    }
+    return result;
+}
+
+} // namespace
+
+LiveSweep::LiveSweep(std::filesystem::path filePath)
+    : m_filePath(std::move(filePath)) {
+}
+
+LiveSweep::LiveSweep(std::filesystem::path filePath, Origin origin)
+    : m_filePath(std::move(filePath))
+    , m_snapshot(std::move(origin.snapshot))
+    , m_complete(std::move(origin.complete))
+    , m_state(origin.state)
+    , m_offset(origin.offset)
+    , m_head(std::move(origin.head))
+    , m_seam(std::move(origin.seam))
+    , m_provisionalSize(origin.provisionalSize)
+    , m_loaded(true)
+    , m_headerFound(true) {
+}
+
+std::optional<LiveSweep::FileState> LiveSweep::fileState(const std::filesystem::path& filePath) {
+    FileState state;
+    std::error_code error;
+    state.size = static_cast<size_t>(std::filesystem::file_size(filePath, error));
+    if (!error) {
+        state.writeTime = std::filesystem::last_write_time(filePath, error);
+    }
+    if (error) {
+        return std::nullopt;
+    }
+    return state;
+}
+
+LiveSweep::Loaded LiveSweep::createLoaded(const std::filesystem::path& filePath, const FileState& before,
+                                          Measurement measurement, LodPyramid lod) {
+    PERF_MEASURE("LiveSweep::createLoaded");
+    
+    // Точки незавершенной строки — последние в measurement; отделить их можно
+    // только у отсортированных точек и только если за время разбора файл не менялся
+    const auto loaded = [&]() -> std::optional<Loaded> {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file || fileState(filePath) != before || measurement.empty()) {
+            return std::nullopt;
+        }
+        
+        const size_t tailBytes = std::min(before.size, maxPendingBytes);
+        const std::string tail = readRange(file, before.size - tailBytes, tailBytes);
+        const size_t length = completeLinesLength(tail);
+        if (tail.size() != tailBytes || length == 0) {
+            return std::nullopt;
+        }
+        
+        Origin origin;
+        origin.state = before;
+        origin.offset = before.size - tailBytes + length;
+        const size_t seamLength = std::min(seamBytes, origin.offset);
+        origin.head = readRange(file, 0, std::min(headBytes, before.size));
+        origin.seam = readRange(file, origin.offset - seamLength, seamLength);
+        if (origin.head.size() != std::min(headBytes, before.size) || origin.seam.size() != seamLength) {
+            return std::nullopt;
+        }
+        origin.provisionalSize = origin.offset < before.size ? before.size : 0;
+        
+        S11Parser::ColumnBlock pending;
+        S11Parser::parseChunk(std::string_view(tail).substr(length), pending);
+        const size_t pendingPoints = pending.frequency.size();
+        if (pendingPoints == 0) {
+            origin.complete = MeasurementSnapshot::create(std::move(measurement), std::move(lod));
+            origin.snapshot = origin.complete;
+            return Loaded{origin.snapshot, std::move(origin)};
+        }
+        
+        const auto frequencies = measurement.frequencies();
+        if (pendingPoints >= measurement.size() || !measurement.isSortedByFrequency() ||
+            !std::equal(pending.frequency.begin(), pending.frequency.end(), frequencies.end() - pendingPoints)) {
+            return std::nullopt;
+        }
+        // Пирамида, построенная при разборе, укорачивается вместе с точками, а не строится заново
+        const size_t completePoints = measurement.size() - pendingPoints;
+        if (lod.isValid() && lod.pointCount() == measurement.size()) {
+            const size_t bucketStart = completePoints - completePoints % lod.bucketSize();
+            std::vector<double> values(completePoints - bucketStart);
+            const auto real = measurement.realParts().subspan(bucketStart, values.size());
+            const auto imag = measurement.imagParts().subspan(bucketStart, values.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                values[i] = logMagnitudeDb(real[i], imag[i]);
+            }
+            lod.truncate(completePoints, frequencies.subspan(bucketStart, values.size()), values);
+        }
+        measurement.truncate(completePoints);
+        origin.complete = MeasurementSnapshot::create(std::move(measurement), std::move(lod));
+        origin.snapshot = MeasurementSnapshot::createAppended(*origin.complete, pending.frequency, pending.real,
+                                                              pending.imag);
+        return Loaded{origin.snapshot, std::move(origin)};
+    }();
+    
+    if (loaded) {
+        return std::move(*loaded);
+    }
+    return Loaded{MeasurementSnapshot::create(std::move(measurement), std::move(lod)), std::nullopt};
+}
+
+std::optional<LiveSweep::Origin> LiveSweep::origin() const {
+    if (!m_loaded || !m_headerFound || !m_complete) {
+        return std::nullopt;
+    }
+    return Origin{m_state, m_offset, m_head, m_seam, m_provisionalSize, m_snapshot, m_complete};
+}
+
+LiveSweep::Update LiveSweep::update(bool forceReload) {
+    PERF_MEASURE("LiveSweep::update");
+    
+    const auto current = fileState(m_filePath);
+    if (!current) {
+        Update update;
+        update.result = S11Parser::ParseResult::FileNotFound;
+        return update;
+    }
+    const FileState& state = *current;
+    
+    if (state == m_state && m_loaded && !forceReload) {
+        // Файл не менялся с прошлого чтения: писатель остановился, незавершенная строка показывается предварительно
+        return m_headerFound && m_offset < state.size && m_provisionalSize != state.size ? appendProvisional(state)
+                                                                                          : Update{};
+    }
+    
+    // Дописывание только увеличивает размер; тот же или меньший размер
+    // с новым временем изменения — файл переписан на месте
+    if (forceReload || !m_loaded || !m_headerFound || state.size <= m_state.size) {
+        return reload(state);
+    }
+    return append(state);
+}
+
+LiveSweep::Update LiveSweep::reload(const FileState& state) {
+    PERF_MEASURE("LiveSweep::reload");
+    
+    Update update;
+    std::ifstream file(m_filePath, std::ios::binary);
+    if (!file) {
+        update.result = S11Parser::ParseResult::FileNotFound;
+        return update;
+    }
+    
+    const std::string content = readRange(file, 0, state.size);
+    update.bytesRead = content.size();
+    
+    m_loaded = true;
+    m_state = state;
+    m_provisionalSize = 0;
+    m_headerFound = S11Parser::hasHeader(content);
+    m_offset = completeLinesLength(content);
+    m_head = content.substr(0, std::min(headBytes, content.size()));
+    m_seam = lastBytes(std::string_view(content).substr(0, m_offset), seamBytes);
+    // Прежние точки относятся к старому содержимому файла
+    m_snapshot.reset();
+    m_complete.reset();
+    update.pendingBytes = content.size() - m_offset;
+    
+    if (!m_headerFound) {
+        update.result = content.empty() ? S11Parser::ParseResult::EmptyFile : S11Parser::ParseResult::InvalidFormat;
+        return update;
+    }
+    
+    publish(update, parseLines(std::string_view(content).substr(0, m_offset)), Change::Reloaded);
+    return update;
+}
+
+LiveSweep::Update LiveSweep::append(const FileState& state) {
+    PERF_MEASURE("LiveSweep::append");
+    
+    std::ifstream file(m_filePath, std::ios::binary);
+    if (!file) {
+        Update update;
+        update.result = S11Parser::ParseResult::FileNotFound;
+        return update;
+    }
+    
+    // Начало файла и байты перед разобранным концом те же — значит, файл только дописан
+    if (readRange(file, 0, m_head.size()) != m_head) {
+        return reload(state);
+    }
+    const size_t seamStart = m_offset - m_seam.size();
+    const std::string text = readRange(file, seamStart, state.size - seamStart);
+    if (text.size() < m_seam.size() || text.compare(0, m_seam.size(), m_seam) != 0) {
+        return reload(state);
+    }
+    m_state = state;
+    
+    const std::string_view appended = std::string_view(text).substr(m_seam.size());
+    const size_t length = completeLinesLength(appended);
+    
+    Update update;
+    update.bytesRead = appended.size();
+    update.pendingBytes = appended.size() - length;
+    if (length == 0) {
+        return update;
+    }
+    
+    m_offset += length;
+    m_seam = lastBytes(std::string_view(text).substr(0, m_seam.size() + length), seamBytes);
+    publish(update, parseLines(appended.substr(0, length)), Change::Appended);
+    return update;
+}
+
+LiveSweep::Update LiveSweep::appendProvisional(const FileState& state) {
+    Update update;
+    std::ifstream file(m_filePath, std::ios::binary);
+    if (!file) {
+        update.result = S11Parser::ParseResult::FileNotFound;
+        return update;
+    }
+    
+    // m_offset не сдвигается: строка разбирается заново, когда допишется
+    const std::string text = readRange(file, m_offset, state.size - m_offset);
+    update.bytesRead = text.size();
+    update.pendingBytes = text.size();
+    m_provisionalSize = state.size;
+    
+    S11Parser::ColumnBlock block;
+    S11Parser::parseChunk(text, block);
+    // Хвост без точки (пробелы, незаконченный комментарий) — показываются только полные строки
+    MeasurementSnapshot::Ptr shown = m_complete;
+    if (!block.frequency.empty()) {
+        shown = MeasurementSnapshot::createAppended(m_complete ? *m_complete : MeasurementSnapshot(),
+                                                    block.frequency, block.real, block.imag);
+    }
+    if (shown == m_snapshot) {
+        return update;
+    }
+    
+    m_snapshot = shown;
+    update.change = Change::Appended;
+    update.snapshot = m_snapshot;
+    update.newPoints = block.frequency.size();
+    return update;
+}
+
+void LiveSweep::publish(Update& update, S11Parser::ColumnBlock block, Change change) {
+    const size_t newPoints = block.frequency.size();
+    if (newPoints == 0) {
+        if (!m_complete) {
+            update.result = S11Parser::ParseResult::EmptyFile;
+        }
+        // Строка с предварительной точкой дописалась во что-то без точки
+        if (m_snapshot != m_complete) {
+            m_snapshot = m_complete;
+            update.change = change;
+            update.snapshot = m_snapshot;
+        }
+        return;
+    }
+    
+    // Предварительная точка не входит в m_complete: дописанная строка ее заменяет
+    if (m_complete) {
+        m_complete = MeasurementSnapshot::createAppended(*m_complete, block.frequency, block.real, block.imag);
+    } else {
+        // Первое чтение: разобранные столбцы становятся снимком без копирования
+        auto measurement = Measurement::fromColumns(std::move(block.frequency), std::move(block.real),
+                                                    std::move(block.imag));
+        measurement.sortByFrequency();
+        m_complete = MeasurementSnapshot::create(std::move(measurement));
+    }
+    m_snapshot = m_complete;
+    update.change = change;
+    update.snapshot = m_snapshot;
+    update.newPoints = newPoints;
+}
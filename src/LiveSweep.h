@@ -0,0 +1,124 @@
+#pragma once
+
+#include "MeasurementSnapshot.h"
+#include "S11Parser.h"
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+
+// Слежение за растущим .s1p: каждый вызов update() дочитывает то, что появилось
+// в файле с прошлого вызова. Дописанные в конец строки разбираются отдельно
+// и добавляются к прежнему снимку (MeasurementSnapshot::createAppended);
+// если файл переписан (стал короче, изменились первые байты или байты перед
+// разобранным концом, или вызывающий знает о замене файла), он разбирается заново.
+// Разобранным считается только то, что до конца последней полной строки.
+// Незавершенная последняя строка, если файл не менялся между двумя вызовами,
+// показывается предварительной точкой поверх снимка полных строк; когда строка
+// допишется, точка заменяется разобранной заново (или пропадает).
+// Слежение может начаться с места, где остановилась обычная загрузка файла
+// (createLoaded) или прежнее слежение (origin()): тогда первое же изменение
+// файла дочитывается, а не разбирается заново.
+// Файл читается обычным чтением, а не mmap: писатель может обрезать его в любой момент.
+// Один объект не вызывается из нескольких потоков одновременно.
+class LiveSweep {
+public:
+    using Ptr = std::shared_ptr<LiveSweep>;
+    
+    enum class Change {
+        // Новых точек нет
+        None,
+        // Разобраны только дописанные байты
+        Appended,
+        // Файл разобран целиком
+        Reloaded
+    };
+    
+    struct Update {
+        Change change = Change::None;
+        // FileNotFound, InvalidFormat и EmptyFile не сбрасывают прежний снимок:
+        // писатель мог еще не дописать заголовок или первые точки
+        S11Parser::ParseResult result = S11Parser::ParseResult::Success;
+        // Новый снимок; nullptr, если показывать нечего нового
+        MeasurementSnapshot::Ptr snapshot;
+        size_t newPoints = 0;
+        size_t bytesRead = 0;
+        // Байты незавершенной последней строки
+        size_t pendingBytes = 0;
+    };
+    
+    // Размер и время изменения при последнем чтении
+    struct FileState {
+        size_t size = 0;
+        std::filesystem::file_time_type writeTime{};
+        
+        [[nodiscard]] bool operator==(const FileState&) const = default;
+    };
+    
+    // Докуда файл разобран и что при этом показано
+    struct Origin {
+        FileState state;
+        // Конец последней полной строки
+        size_t offset = 0;
+        std::string head;
+        std::string seam;
+        // Размер файла, при котором разобрана незавершенная строка; 0 — не разбиралась
+        size_t provisionalSize = 0;
+        // Показанный снимок и снимок только полных строк
+        MeasurementSnapshot::Ptr snapshot;
+        MeasurementSnapshot::Ptr complete;
+    };
+    
+    // Снимок обычной загрузки и место, с которого по нему продолжается слежение
+    struct Loaded {
+        MeasurementSnapshot::Ptr snapshot;
+        // nullopt — файл менялся во время разбора или конец не удалось сопоставить с точками
+        std::optional<Origin> origin;
+    };
+    
+    explicit LiveSweep(std::filesystem::path filePath);
+    // Продолжение с места, где остановилась загрузка или прежнее слежение
+    LiveSweep(std::filesystem::path filePath, Origin origin);
+    
+    // nullopt, если файл недоступен
+    [[nodiscard]] static std::optional<FileState> fileState(const std::filesystem::path& filePath);
+    
+    // Снимок загруженного файла; before — состояние файла до начала разбора.
+    // Точки незавершенной последней строки отделяются от полных строк в свой
+    // кусок так же, как при слежении; пирамида при этом укорачивается, а не строится заново
+    [[nodiscard]] static Loaded createLoaded(const std::filesystem::path& filePath, const FileState& before,
+                                             Measurement measurement, LodPyramid lod = {});
+    
+    // forceReload — файл точно заменен (например, атомарным переименованием)
+    [[nodiscard]] Update update(bool forceReload = false);
+    
+    [[nodiscard]] const std::filesystem::path& filePath() const noexcept { return m_filePath; }
+    [[nodiscard]] const MeasurementSnapshot::Ptr& snapshot() const noexcept { return m_snapshot; }
+    // Место, с которого можно продолжить; nullopt, пока разбирать нечего
+    [[nodiscard]] std::optional<Origin> origin() const;
+    
+private:
+    Update reload(const FileState& state);
+    Update append(const FileState& state);
+    // Предварительная точка из незавершенной последней строки
+    Update appendProvisional(const FileState& state);
+    // Новые точки полных строк добавляются к снимку полных строк
+    void publish(Update& update, S11Parser::ColumnBlock block, Change change);
+    
+    std::filesystem::path m_filePath;
+    // Показываемый снимок: полные строки и, возможно, предварительная точка
+    MeasurementSnapshot::Ptr m_snapshot;
+    // Только полные строки, до m_offset
+    MeasurementSnapshot::Ptr m_complete;
+    FileState m_state;
+    // Разобрано до этого смещения (конец последней полной строки)
+    size_t m_offset = 0;
+    // Первые байты файла и байты перед m_offset: по ним узнается, что файл только дописан
+    std::string m_head;
+    std::string m_seam;
+    // Размер файла, при котором разобрана незавершенная строка; 0 — не разбиралась
+    size_t m_provisionalSize = 0;
+    bool m_loaded = false;
+    bool m_headerFound = false;
+};
@@ -0,0 +1,414 @@
+#include "LodPyramid.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+
+namespace {
+
+using Sample = LodPyramid::Sample;
+using Bucket = LodPyramid::Bucket;
+
+Bucket makeBucket(std::span<const double> frequencies, std::span<const double> values, size_t begin, size_t end) {
+    Bucket bucket;
+    bucket.first = {frequencies[begin], values[begin]};
+    bucket.last = {frequencies[end - 1], values[end - 1]};
+    bucket.min = bucket.first;
+    bucket.max = bucket.first;
+    for (size_t i = begin + 1; i < end; ++i) {
+        if (values[i] < bucket.min.value) {
+            bucket.min = {frequencies[i], values[i]};
+        }
+        if (values[i] > bucket.max.value) {
+            bucket.max = {frequencies[i], values[i]};
+        }
+    }
+    return bucket;
+}
+
+Bucket combine(const Bucket* children, size_t count) {
+    Bucket bucket = children[0];
+    for (size_t i = 1; i < count; ++i) {
+        const Bucket& child = children[i];
+        bucket.last = child.last;
+        if (child.min.value < bucket.min.value) {
+            bucket.min = child.min;
+        }
+        if (child.max.value > bucket.max.value) {
+            bucket.max = child.max;
+        }
+    }
+    return bucket;
+}
+
+// M4-свертка потока точек, упорядоченного по частоте:
+// на каждый пиксельный столбец первая, минимальная, максимальная и последняя точки
+class M4Accumulator {
+public:
+    M4Accumulator(double freqMin, double freqMax, int columns, std::vector<Sample>& out)
+        : m_freqMin(freqMin), m_scale(columns / (freqMax - freqMin)), m_columns(columns), m_out(out) {}
+    
+    ~M4Accumulator() {
+        flush();
+    }
+    
+    [[nodiscard]] bool sameColumn(double frequencyA, double frequencyB) const {
+        return columnOf(frequencyA) == columnOf(frequencyB);
+    }
+    
+    void add(const Sample& sample) {
+        const long column = columnOf(sample.frequency);
+        if (!m_hasColumn || column != m_column) {
+            flush();
+            m_column = column;
+            m_hasColumn = true;
+            m_first = m_last = m_min = m_max = sample;
+            return;
+        }
+        m_last = sample;
+        if (sample.value < m_min.value) {
+            m_min = sample;
+        }
+        if (sample.value > m_max.value) {
+            m_max = sample;
+        }
+    }
+    
+private:
+    long columnOf(double frequency) const {
+        const double column = std::floor((frequency - m_freqMin) * m_scale);
+        // Точки за пределами окна сводятся в столбцы -1 и columns
+        return static_cast<long>(std::clamp(column, -1.0, static_cast<double>(m_columns)));
+    }
+    
+    void emit(const Sample& sample) {
+        if (m_out.empty() || m_out.back().frequency != sample.frequency || m_out.back().value != sample.value) {
+            m_out.push_back(sample);
+        }
+    }
+    
+    void flush() {
+        if (!m_hasColumn) {
+            return;
+        }
+        m_hasColumn = false;
+        
+        // Слева от окна нужна только последняя точка, справа — только первая
+        if (m_column < 0) {
+            emit(m_last);
+            return;
+        }
+        if (m_column >= m_columns) {
+            emit(m_first);
+            return;
+        }
+        
+        emit(m_first);
+        if (m_min.frequency <= m_max.frequency) {
+            emit(m_min);
+            emit(m_max);
+        } else {
+            emit(m_max);
+            emit(m_min);
+        }
+        emit(m_last);
+    }
+    
+    double m_freqMin;
+    double m_scale;
+    int m_columns;
+    std::vector<Sample>& m_out;
+    
+    bool m_hasColumn = false;
+    long m_column = 0;
+    Sample m_first{}, m_last{}, m_min{}, m_max{};
+};
+
+} // namespace
+
+LodPyramid LodPyramid::build(std::span<const double> frequencies, std::span<const double> values) {
+    LodPyramid pyramid;
+    pyramid.append(frequencies, values);
+    return pyramid;
+}
+
+void LodPyramid::append(std::span<const double> frequencies, std::span<const double> values) {
+    PERF_MEASURE("LodPyramid::append");
+    
+    const size_t n = std::min(frequencies.size(), values.size());
+    if (n == 0) {
+        return;
+    }
+    
+    if (m_levels.empty()) {
+        m_levels.emplace_back();
+    }
+    auto& base = m_levels[0];
+    
+    // Сначала дополняется неполная последняя корзина
+    size_t consumed = 0;
+    size_t firstChanged = base.size();
+    const size_t tail = m_pointCount % m_bucketSize;
+    if (tail != 0) {
+        consumed = std::min(n, m_bucketSize - tail);
+        const Bucket parts[2] = {base.back(), makeBucket(frequencies, values, 0, consumed)};
+        base.back() = combine(parts, 2);
+        firstChanged = base.size() - 1;
+    }
+    
+    const size_t oldSize = base.size();
+    const size_t bucketSize = m_bucketSize;
+    base.resize(oldSize + (n - consumed + bucketSize - 1) / bucketSize);
+    std::for_each(
+        std::execution::par_unseq,
+        base.begin() + oldSize, base.end(),
+        [&base, frequencies, values, n, consumed, oldSize, bucketSize](Bucket& bucket) {
+            const size_t begin = consumed + (static_cast<size_t>(&bucket - base.data()) - oldSize) * bucketSize;
+            bucket = makeBucket(frequencies, values, begin, std::min(begin + bucketSize, n));
+        }
+    );
+    m_pointCount += n;
+    
+    // Верхние уровни пересчитываются только начиная с затронутой корзины
+    for (size_t levelIndex = 1; m_levels[levelIndex - 1].size() > 1; ++levelIndex) {
+        if (levelIndex == m_levels.size()) {
+            m_levels.emplace_back();
+        }
+        const auto& previous = m_levels[levelIndex - 1];
+        auto& current = m_levels[levelIndex];
+        
+        firstChanged /= branchFactor;
+        current.resize((previous.size() + branchFactor - 1) / branchFactor);
+        std::for_each(
+            std::execution::par_unseq,
+            current.begin() + firstChanged, current.end(),
+            [&current, &previous](Bucket& bucket) {
+                const size_t begin = static_cast<size_t>(&bucket - current.data()) * branchFactor;
+                const size_t count = std::min(branchFactor, previous.size() - begin);
+                bucket = combine(previous.data() + begin, count);
+            }
+        );
+    }
+}
+
+void LodPyramid::truncate(size_t count, std::span<const double> frequencies, std::span<const double> values) {
+    if (count >= m_pointCount) {
+        return;
+    }
+    if (count == 0) {
+        *this = LodPyramid();
+        return;
+    }
+    
+    auto& base = m_levels[0];
+    base.resize((count + m_bucketSize - 1) / m_bucketSize);
+    if (const size_t tail = count % m_bucketSize; tail != 0) {
+        base.back() = makeBucket(frequencies, values, 0, tail);
+    }
+    m_pointCount = count;
+    
+    // Уровни выше того, где осталась одна корзина, больше не нужны
+    size_t levelIndex = 1;
+    for (; m_levels[levelIndex - 1].size() > 1; ++levelIndex) {
+        const auto& previous = m_levels[levelIndex - 1];
+        auto& current = m_levels[levelIndex];
+        current.resize((previous.size() + branchFactor - 1) / branchFactor);
+        const size_t begin = (current.size() - 1) * branchFactor;
+        current.back() = combine(previous.data() + begin, previous.size() - begin);
+    }
+    m_levels.resize(levelIndex);
+}
+
+LodPyramid LodPyramid::fromLevels(std::vector<std::vector<Bucket>> levels, size_t pointCount, size_t bucketSize) {
+    LodPyramid result;
+    if (levels.empty() || levels.back().size() != 1 || pointCount == 0 || bucketSize == 0 ||
+        levels.front().size() != (pointCount + bucketSize - 1) / bucketSize) {
+        return result;
+    }
+    
+    // Каждый уровень — ceil(n / branchFactor) корзин предыдущего
+    for (size_t i = 1; i < levels.size(); ++i) {
+        if (levels[i].size() != (levels[i - 1].size() + branchFactor - 1) / branchFactor) {
+            return result;
+        }
+    }
+    
+    result.m_levels = std::move(levels);
+    result.m_pointCount = pointCount;
+    result.m_bucketSize = bucketSize;
+    return result;
+}
+
+LodPyramid LodPyramid::coarsened(size_t maxBuckets) const {
+    LodPyramid result;
+    if (!isValid()) {
+        return result;
+    }
+    
+    size_t first = 0;
+    result.m_bucketSize = m_bucketSize;
+    while (first + 1 < m_levels.size() && m_levels[first].size() > maxBuckets) {
+        ++first;
+        result.m_bucketSize *= branchFactor;
+    }
+    
+    result.m_levels.assign(m_levels.begin() + static_cast<std::ptrdiff_t>(first), m_levels.end());
+    result.m_pointCount = m_pointCount;
+    return result;
+}
+
+void LodPyramid::coarsen(size_t maxBuckets) {
+    size_t first = 0;
+    while (first + 1 < m_levels.size() && m_levels[first].size() > maxBuckets) {
+        ++first;
+        m_bucketSize *= branchFactor;
+    }
+    m_levels.erase(m_levels.begin(), m_levels.begin() + static_cast<std::ptrdiff_t>(first));
+}
+
+size_t LodPyramid::memoryBytes() const noexcept {
+    size_t buckets = 0;
+    for (const auto& level : m_levels) {
+        buckets += level.capacity();
+    }
+    return buckets * sizeof(Bucket);
+}
+
+LodPyramid::ValueRange LodPyramid::rangeMinMax(size_t begin, size_t end, std::span<const double> rawValues) const {
+    ValueRange range;
+    end = std::min({end, m_pointCount, rawValues.size()});
+    if (!isValid() || begin >= end) {
+        return range;
+    }
+    
+    const auto addRaw = [&range, rawValues](size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            range.min = std::min(range.min, rawValues[i]);
+            range.max = std::max(range.max, rawValues[i]);
+        }
+    };
+    
+    // Целые корзины уровня 0 внутри диапазона
+    size_t lo = (begin + m_bucketSize - 1) / m_bucketSize;
+    size_t hi = end / m_bucketSize;
+    if (end == m_pointCount) {
+        hi = m_levels[0].size();
+    }
+    
+    if (lo >= hi) {
+        addRaw(begin, end);
+        return range;
+    }
+    addRaw(begin, std::min(lo * m_bucketSize, end));
+    addRaw(std::min(hi * m_bucketSize, end), end);
+    addBuckets(lo, hi, range);
+    
+    return range;
+}
+
+LodPyramid::ValueRange LodPyramid::rangeMinMax(double freqMin, double freqMax) const {
+    ValueRange range;
+    if (!isValid() || freqMax < freqMin) {
+        return range;
+    }
+    
+    const auto& base = m_levels[0];
+    const auto first = std::partition_point(base.begin(), base.end(), [freqMin](const Bucket& bucket) {
+        return bucket.last.frequency < freqMin;
+    });
+    const auto last = std::partition_point(first, base.end(), [freqMax](const Bucket& bucket) {
+        return bucket.first.frequency <= freqMax;
+    });
+    
+    addBuckets(static_cast<size_t>(first - base.begin()), static_cast<size_t>(last - base.begin()), range);
+    return range;
+}
+
+void LodPyramid::addBuckets(size_t lo, size_t hi, ValueRange& range) const {
+    const auto addBucket = [&range](const Bucket& bucket) {
+        range.min = std::min(range.min, bucket.min.value);
+        range.max = std::max(range.max, bucket.max.value);
+    };
+    
+    // Снизу вверх: невыровненные края берутся на текущем уровне, середина — уровнем выше
+    for (size_t levelIndex = 0; lo < hi; ++levelIndex) {
+        const auto& buckets = m_levels[levelIndex];
+        if (levelIndex + 1 == m_levels.size()) {
+            for (size_t i = lo; i < hi; ++i) {
+                addBucket(buckets[i]);
+            }
+            break;
+        }
+        while (lo < hi && lo % branchFactor != 0) {
+            addBucket(buckets[lo++]);
+        }
+        while (lo < hi && hi % branchFactor != 0 && hi != buckets.size()) {
+            addBucket(buckets[--hi]);
+        }
+        if (lo >= hi) {
+            break;
+        }
+        lo /= branchFactor;
+        hi = (hi + branchFactor - 1) / branchFactor;
+    }
+}
+
+bool LodPyramid::query(double freqMin, double freqMax, int columns, std::vector<Sample>& out,
+                       std::span<const double> rawFrequencies,
+                       std::span<const double> rawValues) const {
+    PERF_MEASURE("LodPyramid::query");
+    
+    out.clear();
+    if (!isValid() || columns <= 0 || !(freqMax > freqMin)) {
+        return false;
+    }
+    
+    const bool hasRaw = rawFrequencies.size() >= m_pointCount && rawValues.size() >= m_pointCount;
+    
+    out.reserve(4 * static_cast<size_t>(columns) + 8);
+    M4Accumulator accumulator(freqMin, freqMax, columns, out);
+    
+    const auto visit = [&](auto& self, size_t levelIndex, size_t bucketIndex) -> void {
+        const Bucket& bucket = m_levels[levelIndex][bucketIndex];
+        
+        if (accumulator.sameColumn(bucket.first.frequency, bucket.last.frequency)) {
+            accumulator.add(bucket.first);
+            if (bucket.min.frequency <= bucket.max.frequency) {
+                accumulator.add(bucket.min);
+                accumulator.add(bucket.max);
+            } else {
+                accumulator.add(bucket.max);
+                accumulator.add(bucket.min);
+            }
+            accumulator.add(bucket.last);
+            return;
+        }
+        
+        if (levelIndex > 0) {
+            const size_t childCount = m_levels[levelIndex - 1].size();
+            const size_t begin = bucketIndex * branchFactor;
+            const size_t end = std::min(begin + branchFactor, childCount);
+            for (size_t child = begin; child < end; ++child) {
+                self(self, levelIndex - 1, child);
+            }
+            return;
+        }
+        
+        // Корзина уровня 0 на границе столбцов
+        const size_t begin = bucketIndex * m_bucketSize;
+        const size_t end = std::min(begin + m_bucketSize, m_pointCount);
+        if (hasRaw) {
+            for (size_t i = begin; i < end; ++i) {
+                accumulator.add({rawFrequencies[i], rawValues[i]});
+            }
+        } else {
+            accumulator.add(bucket.first);
+            accumulator.add(bucket.min.frequency <= bucket.max.frequency ? bucket.min : bucket.max);
+            accumulator.add(bucket.min.frequency <= bucket.max.frequency ? bucket.max : bucket.min);
+            accumulator.add(bucket.last);
+        }
+    };
+    
+    visit(visit, m_levels.size() - 1, 0);
+    return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+// Многоуровневая min/max пирамида (M4) для отрисовки больших трасс.
+// Уровень 0: корзины по baseBucketSize соседних точек, каждый следующий
+// уровень объединяет по branchFactor корзин. В корзине хранятся первая,
+// последняя, минимальная и максимальная точки, поэтому локальные экстремумы
+// не теряются ни на одном уровне. Частоты должны быть отсортированы.
+// Пирамиду можно наращивать блоками (append) по мере чтения файла.
+class LodPyramid {
+public:
+    static constexpr size_t baseBucketSize = 32;
+    static constexpr size_t branchFactor = 4;
+    
+    struct Sample {
+        double frequency;
+        double value;
+    };
+    
+    struct Bucket {
+        Sample first;
+        Sample last;
+        Sample min;
+        Sample max;
+    };
+    
+    struct ValueRange {
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        
+        [[nodiscard]] bool isValid() const noexcept { return min <= max; }
+    };
+    
+    LodPyramid() = default;
+    
+    // values — столбец |S11| дБ той же длины, что и frequencies
+    [[nodiscard]] static LodPyramid build(std::span<const double> frequencies, std::span<const double> values);
+    
+    // Добавление точек в конец: пересчитываются только новые корзины и их предки.
+    // Частоты блока должны продолжать уже добавленные по возрастанию.
+    void append(std::span<const double> frequencies, std::span<const double> values);
+    
+    // Оставляет первые count точек: на каждом уровне пересчитывается только последняя корзина.
+    // frequencies и values — точки новой неполной корзины уровня 0, с индекса
+    // count - count % bucketSize() до count (пусто, если count кратно bucketSize())
+    void truncate(size_t count, std::span<const double> frequencies, std::span<const double> values);
+    
+    // Сборка из готовых уровней (например, из кэша на диске); пустая пирамида,
+    // если уровни несогласованы
+    [[nodiscard]] static LodPyramid fromLevels(std::vector<std::vector<Bucket>> levels,
+                                               size_t pointCount, size_t bucketSize);
+    
+    // Копия без нижних уровней: не больше maxBuckets корзин на уровне 0.
+    // Для предпросмотра, исходные точки к ней не прикладываются.
+    [[nodiscard]] LodPyramid coarsened(size_t maxBuckets) const;
+    // То же на месте: нижние уровни освобождаются, дальше можно продолжать append
+    void coarsen(size_t maxBuckets);
+    
+    [[nodiscard]] bool isValid() const noexcept { return !m_levels.empty(); }
+    [[nodiscard]] size_t pointCount() const noexcept { return m_pointCount; }
+    [[nodiscard]] size_t levelCount() const noexcept { return m_levels.size(); }
+    // Точек в корзине уровня 0: baseBucketSize, у огрубленной копии больше
+    [[nodiscard]] size_t bucketSize() const noexcept { return m_bucketSize; }
+    [[nodiscard]] std::span<const Bucket> level(size_t index) const noexcept { return m_levels[index]; }
+    // Память под корзины всех уровней
+    [[nodiscard]] size_t memoryBytes() const noexcept;
+    
+    // Крайние частоты и значения по всем точкам — корень пирамиды, O(1)
+    [[nodiscard]] const Bucket& root() const noexcept { return m_levels.back().front(); }
+    
+    // Min/max значений на полуинтервале индексов [begin, end) за O(log n):
+    // неполные корзины уровня 0 досчитываются по rawValues (не больше 2 * bucketSize() точек),
+    // остальное собирается из готовых корзин на каждом уровне
+    [[nodiscard]] ValueRange rangeMinMax(size_t begin, size_t end, std::span<const double> rawValues) const;
+    
+    // Min/max по корзинам уровня 0, пересекающим [freqMin, freqMax], без исходных точек:
+    // может захватить до bucketSize() лишних точек с каждого края
+    [[nodiscard]] ValueRange rangeMinMax(double freqMin, double freqMax) const;
+    
+    // M4-точки для окна [freqMin, freqMax] шириной columns пикселей (до 4 на столбец).
+    // Спуск по дереву идет только в корзины на границах столбцов; если переданы
+    // исходные столбцы, граничные корзины уровня 0 раскрываются до точек и
+    // результат совпадает с M4 по всем данным.
+    bool query(double freqMin, double freqMax, int columns, std::vector<Sample>& out,
+               std::span<const double> rawFrequencies = {},
+               std::span<const double> rawValues = {}) const;
+    
+private:
+    // Корзины [lo, hi) уровня 0 через готовые корзины верхних уровней
+    void addBuckets(size_t lo, size_t hi, ValueRange& range) const;
+    
+    std::vector<std::vector<Bucket>> m_levels;
+    size_t m_pointCount = 0;
+    size_t m_bucketSize = baseBucketSize;
+};
@@ -0,0 +1,189 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        swap(other);
+    }
+    return *this;
+}
+
+void MappedFile::swap(MappedFile& other) noexcept {
+    std::swap(m_mapping, other.m_mapping);
+    std::swap(m_size, other.m_size);
+    std::swap(m_isOpen, other.m_isOpen);
+    std::swap(m_buffer, other.m_buffer);
+#ifdef _WIN32
+    std::swap(m_fileHandle, other.m_fileHandle);
+    std::swap(m_mappingHandle, other.m_mappingHandle);
+#endif
+}
+
+bool MappedFile::open(const std::filesystem::path& filePath, Access access) {
+    close();
+
+    if (map(filePath, access) || readBuffered(filePath)) {
+        m_isOpen = true;
+    }
+    return m_isOpen;
+}
+
+void MappedFile::close() noexcept {
+#ifdef _WIN32
+    if (m_mapping) {
+        UnmapViewOfFile(m_mapping);
+    }
+    if (m_mappingHandle) {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle) {
+        CloseHandle(m_fileHandle);
+    }
+    m_fileHandle = nullptr;
+    m_mappingHandle = nullptr;
+#else
+    if (m_mapping) {
+        munmap(const_cast<char*>(m_mapping), m_size);
+    }
+#endif
+    m_mapping = nullptr;
+    m_size = 0;
+    m_isOpen = false;
+    m_buffer = {};
+}
+
+#ifdef _WIN32
+
+bool MappedFile::map(const std::filesystem::path& filePath, Access access) {
+    const DWORD flags = access == Access::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_mapping = static_cast<const char*>(view);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::discard(size_t offset, size_t bytes) const noexcept {
+    if (!m_mapping || offset >= m_size) {
+        return;
+    }
+    // Для незаблокированных страниц VirtualUnlock убирает их из рабочего набора
+    VirtualUnlock(const_cast<char*>(m_mapping) + offset, std::min(bytes, m_size - offset));
+}
+
+#else
+
+bool MappedFile::map(const std::filesystem::path& filePath, Access access) {
+    const int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Отображение держит ссылку на файл, дескриптор больше не нужен
+    ::close(fd);
+
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    madvise(view, size, access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+    if (access == Access::Sequential) {
+        madvise(view, size, MADV_WILLNEED);
+    }
+
+    m_mapping = static_cast<const char*>(view);
+    m_size = size;
+    return true;
+}
+
+void MappedFile::discard(size_t offset, size_t bytes) const noexcept {
+    if (!m_mapping || offset >= m_size) {
+        return;
+    }
+
+    // Частично задетые страницы тоже отпускаются: файл только читается, данные не теряются
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = offset / pageSize * pageSize;
+    const size_t end = std::min(offset + bytes, m_size);
+    madvise(const_cast<char*>(m_mapping) + begin, end - begin, MADV_DONTNEED);
+}
+
+#endif
+
+// Запасной путь: пустые файлы, сетевые ФС и платформы без mmap
+bool MappedFile::readBuffered(const std::filesystem::path& filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size(filePath, ec);
+    if (ec) {
+        return false;
+    }
+
+    m_buffer.resize(static_cast<size_t>(fileSize));
+    if (!m_buffer.empty()) {
+        file.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.resize(static_cast<size_t>(file.gcount()));
+    }
+    m_size = m_buffer.size();
+    return true;
+}
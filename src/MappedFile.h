@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Read-only отображение файла в память.
+// Если mmap недоступен, файл читается целиком в буфер (bytesCopied() > 0).
+class MappedFile {
+public:
+    enum class Access {
+        Sequential,
+        Random,
+        // Один проход по файлу, который может не поместиться в память: без упреждающего чтения целиком
+        Streaming
+    };
+
+    MappedFile() noexcept = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::filesystem::path& filePath, Access access = Access::Sequential);
+    void close() noexcept;
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_isOpen; }
+    [[nodiscard]] bool isMapped() const noexcept { return m_mapping != nullptr; }
+    [[nodiscard]] size_t size() const noexcept { return m_size; }
+    [[nodiscard]] size_t bytesCopied() const noexcept { return m_buffer.size(); }
+
+    // Страницы диапазона больше не нужны процессу; при обращении они перечитаются из файла
+    void discard(size_t offset, size_t bytes) const noexcept;
+
+    [[nodiscard]] std::string_view view() const noexcept {
+        if (m_mapping) {
+            return {m_mapping, m_size};
+        }
+        return {m_buffer.data(), m_buffer.size()};
+    }
+
+private:
+    bool map(const std::filesystem::path& filePath, Access access);
+    bool readBuffered(const std::filesystem::path& filePath);
+    void swap(MappedFile& other) noexcept;
+
+    const char* m_mapping = nullptr;
+    size_t m_size = 0;
+    bool m_isOpen = false;
+    std::vector<char> m_buffer;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#endif
+};
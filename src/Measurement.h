@@ -4,6 +4,14 @@
 #include <complex>
 #include <span>
 #include <ranges>
+#include <atomic>
+#include <mutex>
+#include <cmath>
+#include <iterator>
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <utility>
 
 struct FrequencyPoint {
     double frequency;
@@ -15,54 +23,294 @@ struct FrequencyPoint {
         : frequency(freq), s11(s11_val) {}
 };
 
-// Контейнер в STL стиле
+// |S11| в дБ: 20*log10(|z|) == 10*log10(re^2 + im^2)
+[[nodiscard]] inline double logMagnitudeDb(double re, double im) noexcept {
+    return 10.0 * std::log10(re * re + im * im);
+}
+
+// Контейнер в STL стиле. Данные хранятся по столбцам (частота, Re, Im),
+// столбец |S11| дБ считается лениво и сбрасывается при любом изменении.
+// Флаг сортировки по частоте поддерживается при каждом изменении.
 class Measurement {
 public:
-    std::vector<FrequencyPoint> data;
+    // Итератор по точкам; точки собираются из столбцов по значению
+    class PointIterator {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = FrequencyPoint;
+        using difference_type = std::ptrdiff_t;
+        using reference = FrequencyPoint;
+        
+        PointIterator() noexcept = default;
+        PointIterator(const Measurement* owner, size_t index) noexcept : m_owner(owner), m_index(index) {}
+        
+        FrequencyPoint operator*() const { return (*m_owner)[m_index]; }
+        FrequencyPoint operator[](difference_type n) const { return (*m_owner)[m_index + n]; }
+        
+        PointIterator& operator++() noexcept { ++m_index; return *this; }
+        PointIterator operator++(int) noexcept { auto copy = *this; ++m_index; return copy; }
+        PointIterator& operator--() noexcept { --m_index; return *this; }
+        PointIterator operator--(int) noexcept { auto copy = *this; --m_index; return copy; }
+        PointIterator& operator+=(difference_type n) noexcept { m_index += n; return *this; }
+        PointIterator& operator-=(difference_type n) noexcept { m_index -= n; return *this; }
+        
+        friend PointIterator operator+(PointIterator it, difference_type n) noexcept { return it += n; }
+        friend PointIterator operator+(difference_type n, PointIterator it) noexcept { return it += n; }
+        friend PointIterator operator-(PointIterator it, difference_type n) noexcept { return it -= n; }
+        friend difference_type operator-(const PointIterator& a, const PointIterator& b) noexcept {
+            return static_cast<difference_type>(a.m_index) - static_cast<difference_type>(b.m_index);
+        }
+        friend bool operator==(const PointIterator& a, const PointIterator& b) noexcept { return a.m_index == b.m_index; }
+        friend auto operator<=>(const PointIterator& a, const PointIterator& b) noexcept { return a.m_index <=> b.m_index; }
+        
+    private:
+        const Measurement* m_owner = nullptr;
+        size_t m_index = 0;
+    };
+    
+    Measurement() = default;
+    
+    Measurement(const Measurement& other)
+        : m_frequency(other.m_frequency), m_real(other.m_real), m_imag(other.m_imag),
+          m_sortedByFrequency(other.m_sortedByFrequency) {
+        if (other.m_logMagValid.load(std::memory_order_acquire)) {
+            m_logMagDb = other.m_logMagDb;
+            m_logMagValid.store(true, std::memory_order_relaxed);
+        }
+    }
+    
+    Measurement(Measurement&& other) noexcept
+        : m_frequency(std::move(other.m_frequency)), m_real(std::move(other.m_real)),
+          m_imag(std::move(other.m_imag)), m_logMagDb(std::move(other.m_logMagDb)),
+          m_logMagValid(other.m_logMagValid.exchange(false)),
+          m_sortedByFrequency(std::exchange(other.m_sortedByFrequency, true)) {}
+    
+    Measurement& operator=(const Measurement& other) {
+        if (this != &other) {
+            Measurement copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+    
+    Measurement& operator=(Measurement&& other) noexcept {
+        if (this != &other) {
+            m_frequency = std::move(other.m_frequency);
+            m_real = std::move(other.m_real);
+            m_imag = std::move(other.m_imag);
+            m_logMagDb = std::move(other.m_logMagDb);
+            m_logMagValid.store(other.m_logMagValid.exchange(false));
+            m_sortedByFrequency = std::exchange(other.m_sortedByFrequency, true);
+        }
+        return *this;
+    }
+    
+    // Сборка из готовых столбцов без копирования
+    [[nodiscard]] static Measurement fromColumns(std::vector<double> frequency,
+                                                 std::vector<double> real,
+                                                 std::vector<double> imag) {
+        Measurement measurement;
+        measurement.m_frequency = std::move(frequency);
+        measurement.m_real = std::move(real);
+        measurement.m_imag = std::move(imag);
+        measurement.m_sortedByFrequency = std::is_sorted(measurement.m_frequency.begin(), measurement.m_frequency.end());
+        return measurement;
+    }
+    
+    // То же с уже посчитанным столбцом |S11| дБ (той же длины)
+    [[nodiscard]] static Measurement fromColumns(std::vector<double> frequency,
+                                                 std::vector<double> real,
+                                                 std::vector<double> imag,
+                                                 std::vector<double> logMagDb) {
+        Measurement measurement = fromColumns(std::move(frequency), std::move(real), std::move(imag));
+        if (logMagDb.size() == measurement.size()) {
+            measurement.m_logMagDb = std::move(logMagDb);
+            measurement.m_logMagValid.store(true, std::memory_order_release);
+        }
+        return measurement;
+    }
+    
+    // Столбцы, о которых вызывающий уже знает, что частоты идут по возрастанию:
+    // флаг сортировки ставится без повторного прохода по частотам
+    [[nodiscard]] static Measurement fromSortedColumns(std::vector<double> frequency,
+                                                       std::vector<double> real,
+                                                       std::vector<double> imag,
+                                                       std::vector<double> logMagDb) {
+        Measurement measurement;
+        measurement.m_frequency = std::move(frequency);
+        measurement.m_real = std::move(real);
+        measurement.m_imag = std::move(imag);
+        if (logMagDb.size() == measurement.size()) {
+            measurement.m_logMagDb = std::move(logMagDb);
+            measurement.m_logMagValid.store(true, std::memory_order_release);
+        }
+        return measurement;
+    }
     
     template<typename T>
     void addPoint(T frequency, std::complex<T> s11) {
         static_assert(std::is_floating_point_v<T>, "T must be floating point type");
-        data.emplace_back(static_cast<double>(frequency), 
-                         std::complex<double>(s11.real(), s11.imag()));
+        if (!m_frequency.empty() && static_cast<double>(frequency) < m_frequency.back()) {
+            m_sortedByFrequency = false;
+        }
+        m_frequency.push_back(static_cast<double>(frequency));
+        m_real.push_back(static_cast<double>(s11.real()));
+        m_imag.push_back(static_cast<double>(s11.imag()));
+        invalidateDerived();
     }
     
     void clear() noexcept {
-        data.clear();
+        m_frequency.clear();
+        m_real.clear();
+        m_imag.clear();
+        m_sortedByFrequency = true;
+        invalidateDerived();
+    }
+    
+    // Оставляет первые count точек; посчитанный столбец |S11| дБ укорачивается вместе с ними
+    void truncate(size_t count) {
+        if (count >= size()) {
+            return;
+        }
+        m_frequency.resize(count);
+        m_real.resize(count);
+        m_imag.resize(count);
+        
+        std::lock_guard lock(m_cacheMutex);
+        if (m_logMagValid.load(std::memory_order_relaxed)) {
+            m_logMagDb.resize(count);
+        }
+        if (!m_sortedByFrequency) {
+            m_sortedByFrequency = std::is_sorted(m_frequency.begin(), m_frequency.end());
+        }
     }
     
-    [[nodiscard]] constexpr size_t size() const noexcept {
-        return data.size();
+    [[nodiscard]] size_t size() const noexcept {
+        return m_frequency.size();
     }
     
-    [[nodiscard]] constexpr bool empty() const noexcept {
-        return data.empty();
+    [[nodiscard]] bool empty() const noexcept {
+        return m_frequency.empty();
     }
     
-    [[nodiscard]] const FrequencyPoint& operator[](size_t index) const {
-        return data[index];
+    [[nodiscard]] FrequencyPoint operator[](size_t index) const {
+        return FrequencyPoint(m_frequency[index], std::complex<double>(m_real[index], m_imag[index]));
     }
     
-    [[nodiscard]] auto begin() const noexcept { return data.begin(); }
-    [[nodiscard]] auto end() const noexcept { return data.end(); }
-    [[nodiscard]] auto begin() noexcept { return data.begin(); }
-    [[nodiscard]] auto end() noexcept { return data.end(); }
+    [[nodiscard]] PointIterator begin() const noexcept { return PointIterator(this, 0); }
+    [[nodiscard]] PointIterator end() const noexcept { return PointIterator(this, size()); }
     
     void reserve(size_t capacity) {
-        data.reserve(capacity);
+        m_frequency.reserve(capacity);
+        m_real.reserve(capacity);
+        m_imag.reserve(capacity);
+    }
+    
+    [[nodiscard]] bool isSortedByFrequency() const noexcept { return m_sortedByFrequency; }
+    
+    // Память под столбцы, включая кэш |S11| дБ
+    [[nodiscard]] size_t memoryBytes() const {
+        std::lock_guard lock(m_cacheMutex);
+        return (m_frequency.capacity() + m_real.capacity() + m_imag.capacity() + m_logMagDb.capacity()) * sizeof(double);
+    }
+    
+    // Устойчивая сортировка по частоте: точки с одинаковой частотой
+    // сохраняют исходный порядок
+    void sortByFrequency() {
+        if (m_sortedByFrequency) {
+            return;
+        }
+        
+        std::vector<size_t> order(size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(
+            std::execution::par,
+            order.begin(), order.end(),
+            [this](size_t a, size_t b) { return m_frequency[a] < m_frequency[b]; }
+        );
+        
+        const auto permute = [&order](std::vector<double>& column) {
+            std::vector<double> sorted(column.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                sorted[i] = column[order[i]];
+            }
+            column = std::move(sorted);
+        };
+        permute(m_frequency);
+        permute(m_real);
+        permute(m_imag);
+        
+        m_sortedByFrequency = true;
+        invalidateDerived();
+    }
+    
+    // Полуинтервал индексов [first, second) точек с частотой в [freqMin, freqMax]
+    // плюс по одному соседу с каждой стороны, чтобы линия доходила до края окна.
+    // Для неотсортированных данных — все точки.
+    [[nodiscard]] std::pair<size_t, size_t> visibleRange(double freqMin, double freqMax) const {
+        if (!m_sortedByFrequency) {
+            return {0, size()};
+        }
+        
+        const auto first = std::lower_bound(m_frequency.begin(), m_frequency.end(), freqMin);
+        const auto last = std::upper_bound(first, m_frequency.end(), freqMax);
+        
+        const size_t begin = static_cast<size_t>(first - m_frequency.begin());
+        const size_t end = static_cast<size_t>(last - m_frequency.begin());
+        return {begin > 0 ? begin - 1 : 0, std::min(end + 1, size())};
     }
     
-    [[nodiscard]] std::span<const FrequencyPoint> span() const noexcept {
-        return std::span(data);
+    // Столбцы с единичным шагом для горячих циклов
+    [[nodiscard]] std::span<const double> frequencies() const noexcept { return m_frequency; }
+    [[nodiscard]] std::span<const double> realParts() const noexcept { return m_real; }
+    [[nodiscard]] std::span<const double> imagParts() const noexcept { return m_imag; }
+    
+    // |S11| дБ, вычисляется при первом обращении
+    [[nodiscard]] std::span<const double> logMagnitudes() const {
+        if (!m_logMagValid.load(std::memory_order_acquire)) {
+            std::lock_guard lock(m_cacheMutex);
+            if (!m_logMagValid.load(std::memory_order_relaxed)) {
+                m_logMagDb.resize(size());
+                std::transform(
+                    std::execution::par_unseq,
+                    m_real.begin(), m_real.end(),
+                    m_imag.begin(),
+                    m_logMagDb.begin(),
+                    [](double re, double im) { return logMagnitudeDb(re, im); }
+                );
+                m_logMagValid.store(true, std::memory_order_release);
+            }
+        }
+        return m_logMagDb;
+    }
+    
+    [[nodiscard]] auto span() const noexcept {
+        return std::ranges::subrange(begin(), end());
     }
     
     template<typename Predicate>
     [[nodiscard]] auto filter(Predicate&& pred) const {
-        return data | std::views::filter(std::forward<Predicate>(pred));
+        return span() | std::views::filter(std::forward<Predicate>(pred));
     }
     
     template<typename Transform>
     [[nodiscard]] auto transform(Transform&& trans) const {
-        return data | std::views::transform(std::forward<Transform>(trans));
+        return span() | std::views::transform(std::forward<Transform>(trans));
+    }
+    
+private:
+    void invalidateDerived() noexcept {
+        m_logMagValid.store(false, std::memory_order_relaxed);
     }
+    
+    std::vector<double> m_frequency;
+    std::vector<double> m_real;
+    std::vector<double> m_imag;
+    
+    mutable std::vector<double> m_logMagDb;
+    mutable std::atomic<bool> m_logMagValid{false};
+    mutable std::mutex m_cacheMutex;
+    
+    bool m_sortedByFrequency = true;
 };
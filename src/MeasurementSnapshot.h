@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <span>
+#include <vector>
+#include <QtGlobal>
+#include "Measurement.h"
+#include "LodPyramid.h"
+#include "OutOfCoreSweep.h"
+#include "GraphRenderer.h"
+#include "PerformanceUtils.h"
+
+// Неизменяемый снимок загруженного файла: измерение, LOD-пирамида и границы.
+// Публикуется как shared_ptr<const>, поэтому Backend, GraphWidget и рабочие
+// потоки отрисовки делят одну копию данных; замена снимка — атомарная замена
+// указателя, читатели держат старый снимок, пока он им нужен.
+// Точки хранятся неизменяемыми кусками (Chunk) со своей пирамидой у каждого.
+// У загруженного файла кусок один; при слежении за файлом новый снимок делит
+// с прежним все его куски и добавляет только дописанные точки.
+class MeasurementSnapshot {
+public:
+    using Ptr = std::shared_ptr<const MeasurementSnapshot>;
+    
+    struct Chunk {
+        Measurement measurement;
+        LodPyramid lod;
+    };
+    using ChunkPtr = std::shared_ptr<const Chunk>;
+    
+    // Дописанные точки режутся на куски по chunkPoints (пять полных уровней пирамиды):
+    // неполным бывает только последний, и при следующем дописывании копируется только он
+    static constexpr size_t chunkPoints = LodPyramid::baseBucketSize * 1024;
+    
+    MeasurementSnapshot() = default;
+    
+    // Собирается в рабочем потоке: пирамида и границы считаются здесь же.
+    // Пирамиду, уже построенную при потоковом разборе, можно передать готовой
+    [[nodiscard]] static Ptr create(Measurement measurement, LodPyramid lod = {}) {
+        PERF_MEASURE("MeasurementSnapshot::create");
+        auto chunk = std::make_shared<Chunk>();
+        chunk->measurement = std::move(measurement);
+        if (chunk->measurement.isSortedByFrequency()) {
+            if (lod.isValid() && lod.pointCount() == chunk->measurement.size()) {
+                chunk->lod = std::move(lod);
+            } else {
+                chunk->lod = LodPyramid::build(chunk->measurement.frequencies(), chunk->measurement.logMagnitudes());
+            }
+        }
+        
+        auto snapshot = std::make_shared<MeasurementSnapshot>();
+        snapshot->m_chunks.push_back(std::move(chunk));
+        snapshot->finishChunks();
+        return snapshot;
+    }
+    
+    // Точки, дописанные в конец файла (слежение за файлом). Прежние куски
+    // общие с previous; копируется только неполный последний кусок, |S11| дБ
+    // и корзины пирамид считаются только для новых точек. Если новые частоты
+    // не продолжают прежние по возрастанию, снимок собирается заново с сортировкой
+    [[nodiscard]] static Ptr createAppended(const MeasurementSnapshot& previous,
+                                            std::span<const double> frequency,
+                                            std::span<const double> real,
+                                            std::span<const double> imag) {
+        PERF_MEASURE("MeasurementSnapshot::createAppended");
+        const auto& chunks = previous.m_chunks;
+        const bool continues = !previous.m_outOfCore && !previous.m_isPreview && previous.m_pointCount > 0 &&
+                               chunks.back()->measurement.isSortedByFrequency() && chunks.back()->lod.isValid() &&
+                               (frequency.empty() || frequency.front() >= chunks.back()->lod.root().last.frequency) &&
+                               std::is_sorted(frequency.begin(), frequency.end());
+        if (!continues) {
+            return createMerged(previous, frequency, real, imag);
+        }
+        
+        auto snapshot = std::make_shared<MeasurementSnapshot>();
+        snapshot->m_chunks = chunks;
+        
+        // Неполный последний кусок дополняется до chunkPoints, остальное — новыми кусками
+        size_t consumed = 0;
+        if (const Chunk& last = *chunks.back(); last.measurement.size() < chunkPoints) {
+            consumed = std::min(frequency.size(), chunkPoints - last.measurement.size());
+            snapshot->m_chunks.back() = makeChunk(&last, frequency.first(consumed), real.first(consumed),
+                                                  imag.first(consumed));
+        }
+        while (consumed < frequency.size()) {
+            const size_t count = std::min(chunkPoints, frequency.size() - consumed);
+            snapshot->m_chunks.push_back(makeChunk(nullptr, frequency.subspan(consumed, count),
+                                                   real.subspan(consumed, count), imag.subspan(consumed, count)));
+            consumed += count;
+        }
+        
+        snapshot->finishChunks();
+        return snapshot;
+    }
+    
+    // Предпросмотр во время загрузки: только огрубленная пирамида без исходных точек
+    [[nodiscard]] static Ptr createPreview(LodPyramid coarseLod) {
+        auto snapshot = std::make_shared<MeasurementSnapshot>();
+        snapshot->m_lod = std::move(coarseLod);
+        snapshot->m_pointCount = snapshot->m_lod.pointCount();
+        snapshot->m_dataBounds = GraphRenderer::calculateBounds(snapshot->m_lod);
+        snapshot->m_version = nextVersion();
+        snapshot->m_isPreview = true;
+        return snapshot;
+    }
+    
+    // Файл больше памяти: точки не загружены, пирамида общая с источником
+    [[nodiscard]] static Ptr createOutOfCore(OutOfCoreSweep::Ptr source) {
+        auto snapshot = std::make_shared<MeasurementSnapshot>();
+        snapshot->m_outOfCore = std::move(source);
+        snapshot->m_pointCount = snapshot->m_outOfCore->pointCount();
+        snapshot->m_dataBounds = GraphRenderer::calculateBounds(snapshot->m_outOfCore->lod());
+        snapshot->m_version = nextVersion();
+        return snapshot;
+    }
+    
+    // Куски точек по возрастанию частоты; у предпросмотра и файла больше памяти их нет
+    [[nodiscard]] const std::vector<ChunkPtr>& chunks() const noexcept { return m_chunks; }
+    // Пирамида предпросмотра или файла больше памяти; у загруженных точек — по кускам
+    [[nodiscard]] const LodPyramid& lod() const noexcept { return m_outOfCore ? m_outOfCore->lod() : m_lod; }
+    // Трасса для отрисовки и автомасштаба: куски, а без точек — одна пирамида
+    [[nodiscard]] std::vector<GraphRenderer::TracePart> parts() const {
+        static const Measurement noPoints;
+        std::vector<GraphRenderer::TracePart> result;
+        if (m_chunks.empty()) {
+            result.push_back({&noPoints, &lod()});
+            return result;
+        }
+        result.reserve(m_chunks.size());
+        for (const ChunkPtr& chunk : m_chunks) {
+            result.push_back({&chunk->measurement, &chunk->lod});
+        }
+        return result;
+    }
+    // Источник точек по требованию; nullptr, если все точки в chunks()
+    [[nodiscard]] const OutOfCoreSweep::Ptr& outOfCore() const noexcept { return m_outOfCore; }
+    [[nodiscard]] const GraphRenderer::GraphBounds& dataBounds() const noexcept { return m_dataBounds; }
+    // Уникальный номер снимка, ключ для кэшей
+    [[nodiscard]] quint64 version() const noexcept { return m_version; }
+    [[nodiscard]] bool isPreview() const noexcept { return m_isPreview; }
+    [[nodiscard]] size_t size() const noexcept { return m_pointCount; }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    
+    // Точки, загруженные в память: у предпросмотра и файла больше памяти их нет
+    [[nodiscard]] size_t residentPoints() const noexcept { return m_chunks.empty() ? 0 : m_pointCount; }
+    // Память под точки и пирамиды (у файла больше памяти — под пирамиду и индекс)
+    [[nodiscard]] size_t residentBytes() const {
+        if (m_outOfCore) {
+            return m_outOfCore->residentBytes();
+        }
+        size_t bytes = m_lod.memoryBytes();
+        for (const ChunkPtr& chunk : m_chunks) {
+            bytes += chunk->measurement.memoryBytes() + chunk->lod.memoryBytes();
+        }
+        return bytes;
+    }
+    
+private:
+    static quint64 nextVersion() noexcept {
+        static std::atomic<quint64> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    
+    // Кусок из точек base (если есть) и новых точек, которые продолжают их по возрастанию
+    [[nodiscard]] static ChunkPtr makeChunk(const Chunk* base, std::span<const double> frequency,
+                                            std::span<const double> real, std::span<const double> imag) {
+        const auto concat = [](std::span<const double> head, std::span<const double> tail) {
+            std::vector<double> column;
+            column.reserve(head.size() + tail.size());
+            column.insert(column.end(), head.begin(), head.end());
+            column.insert(column.end(), tail.begin(), tail.end());
+            return column;
+        };
+        
+        std::vector<double> magnitudes(frequency.size());
+        std::transform(real.begin(), real.end(), imag.begin(), magnitudes.begin(),
+                       [](double re, double im) { return logMagnitudeDb(re, im); });
+        
+        auto chunk = std::make_shared<Chunk>();
+        if (!base) {
+            chunk->lod = LodPyramid::build(frequency, magnitudes);
+            chunk->measurement = Measurement::fromSortedColumns({frequency.begin(), frequency.end()},
+                                                                {real.begin(), real.end()},
+                                                                {imag.begin(), imag.end()},
+                                                                std::move(magnitudes));
+            return chunk;
+        }
+        
+        chunk->lod = base->lod;
+        chunk->lod.append(frequency, magnitudes);
+        const Measurement& head = base->measurement;
+        chunk->measurement = Measurement::fromSortedColumns(concat(head.frequencies(), frequency),
+                                                            concat(head.realParts(), real),
+                                                            concat(head.imagParts(), imag),
+                                                            concat(head.logMagnitudes(), magnitudes));
+        return chunk;
+    }
+    
+    // Новые точки не по порядку: все куски и новые точки сводятся в один отсортированный кусок
+    [[nodiscard]] static Ptr createMerged(const MeasurementSnapshot& previous, std::span<const double> frequency,
+                                          std::span<const double> real, std::span<const double> imag) {
+        std::vector<double> allFrequency, allReal, allImag;
+        const size_t total = previous.residentPoints() + frequency.size();
+        allFrequency.reserve(total);
+        allReal.reserve(total);
+        allImag.reserve(total);
+        const auto add = [&](std::span<const double> f, std::span<const double> re, std::span<const double> im) {
+            allFrequency.insert(allFrequency.end(), f.begin(), f.end());
+            allReal.insert(allReal.end(), re.begin(), re.end());
+            allImag.insert(allImag.end(), im.begin(), im.end());
+        };
+        for (const ChunkPtr& chunk : previous.m_chunks) {
+            add(chunk->measurement.frequencies(), chunk->measurement.realParts(), chunk->measurement.imagParts());
+        }
+        add(frequency, real, imag);
+        
+        auto measurement = Measurement::fromColumns(std::move(allFrequency), std::move(allReal), std::move(allImag));
+        measurement.sortByFrequency();
+        return create(std::move(measurement));
+    }
+    
+    // Число точек, границы и номер по готовым кускам: O(число кусков)
+    void finishChunks() {
+        m_pointCount = 0;
+        for (const ChunkPtr& chunk : m_chunks) {
+            m_pointCount += chunk->measurement.size();
+        }
+        m_dataBounds = GraphRenderer::calculateBounds(parts());
+        m_version = nextVersion();
+    }
+    
+    std::vector<ChunkPtr> m_chunks;
+    LodPyramid m_lod;
+    OutOfCoreSweep::Ptr m_outOfCore;
+    GraphRenderer::GraphBounds m_dataBounds{};
+    size_t m_pointCount = 0;
+    quint64 m_version = 0;
+    bool m_isPreview = false;
+};
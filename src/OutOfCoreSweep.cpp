@@ -0,0 +1,207 @@
+#include "OutOfCoreSweep.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <execution>
+#include <limits>
+#include <thread>
+
+namespace {
+
+// Доли memoryLimit: пирамида, индекс и окно полного разрешения
+constexpr size_t pyramidShare = 2;   // 1/2
+constexpr size_t indexShare = 16;    // 1/16
+constexpr size_t windowShare = 4;    // 1/4
+
+// Байт на точку окна: частота, Re, Im, |S11| дБ и с запасом пирамида по ним
+constexpr size_t windowBytesPerPoint = 4 * sizeof(double) + 2 * sizeof(LodPyramid::Bucket) / LodPyramid::baseBucketSize;
+
+constexpr size_t streamChunkBytes = 1024 * 1024;
+
+} // namespace
+
+OutOfCoreSweep::OpenExpected OutOfCoreSweep::open(const std::filesystem::path& filePath, const Options& options) {
+    PERF_MEASURE("OutOfCoreSweep::open");
+    
+    auto sweep = std::make_shared<OutOfCoreSweep>();
+    sweep->m_memoryLimit = options.memoryLimit;
+    
+    if (!sweep->m_file.open(filePath, MappedFile::Access::Streaming)) {
+        return S11Parser::ParseResult::FileNotFound;
+    }
+    
+    const std::string_view content = sweep->m_file.view();
+    if (!S11Parser::hasHeader(content)) {
+        return S11Parser::ParseResult::InvalidFormat;
+    }
+    
+    // Уровень 0 пирамиды занимает около 3/4 всех ее корзин
+    const size_t maxBaseBuckets = std::max<size_t>(
+        1, options.memoryLimit / pyramidShare / sizeof(LodPyramid::Bucket) * 3 / 4);
+    const size_t maxIndexEntries = std::max<size_t>(2, options.memoryLimit / indexShare / sizeof(IndexEntry));
+    
+    const auto chunks = S11Parser::splitIntoChunks(content, streamChunkBytes);
+    const size_t waveSize = std::max(1u, std::thread::hardware_concurrency());
+    
+    // Волнами по числу потоков: блоки разбираются параллельно, а в пирамиду
+    // и индекс попадают по порядку; после волны страницы файла отпускаются
+    std::vector<S11Parser::ColumnBlock> blocks;
+    std::vector<double> magnitudes;
+    size_t indexStride = 1;
+    size_t chunkIndex = 0;
+    double lastFrequency = -std::numeric_limits<double>::infinity();
+    
+    for (size_t waveBegin = 0; waveBegin < chunks.size(); waveBegin += waveSize) {
+        if (options.stopToken.stop_requested()) {
+            return S11Parser::ParseResult::Cancelled;
+        }
+        
+        const size_t waveEnd = std::min(waveBegin + waveSize, chunks.size());
+        blocks.assign(waveEnd - waveBegin, {});
+        std::for_each(
+            std::execution::par,
+            blocks.begin(), blocks.end(),
+            [&blocks, &chunks, waveBegin](S11Parser::ColumnBlock& block) {
+                S11Parser::parseChunk(chunks[waveBegin + static_cast<size_t>(&block - blocks.data())], block);
+            }
+        );
+        
+        for (size_t i = waveBegin; i < waveEnd; ++i) {
+            const auto& block = blocks[i - waveBegin];
+            const auto& chunk = chunks[i];
+            
+            // Индекс прореживается вдвое, когда перестает укладываться в свою долю;
+            // запись 0 (начало файла) остается всегда
+            if (chunkIndex % indexStride == 0 && sweep->m_index.size() == maxIndexEntries) {
+                for (size_t j = 0; j < sweep->m_index.size() / 2; ++j) {
+                    sweep->m_index[j] = sweep->m_index[2 * j];
+                }
+                sweep->m_index.resize(sweep->m_index.size() / 2);
+                indexStride *= 2;
+            }
+            if (chunkIndex % indexStride == 0) {
+                sweep->m_index.push_back({static_cast<size_t>(chunk.data() - content.data()),
+                                          sweep->m_lod.pointCount()});
+            }
+            ++chunkIndex;
+            
+            if (block.frequency.empty()) {
+                continue;
+            }
+            
+            // Без исходных точек отсортировать нельзя
+            if (block.frequency.front() < lastFrequency ||
+                !std::is_sorted(block.frequency.begin(), block.frequency.end())) {
+                return S11Parser::ParseResult::UnsortedFrequencies;
+            }
+            lastFrequency = block.frequency.back();
+            
+            magnitudes.resize(block.frequency.size());
+            std::transform(
+                std::execution::par_unseq,
+                block.real.begin(), block.real.end(),
+                block.imag.begin(),
+                magnitudes.begin(),
+                [](double re, double im) { return logMagnitudeDb(re, im); }
+            );
+            sweep->m_lod.append(block.frequency, magnitudes);
+        }
+        
+        sweep->m_lod.coarsen(maxBaseBuckets);
+        
+        const size_t waveBytesBegin = static_cast<size_t>(chunks[waveBegin].data() - content.data());
+        const size_t waveBytesEnd = static_cast<size_t>(chunks[waveEnd - 1].data() - content.data()) +
+                                    chunks[waveEnd - 1].size();
+        sweep->m_file.discard(waveBytesBegin, waveBytesEnd - waveBytesBegin);
+        if (options.bytesParsed) {
+            options.bytesParsed->fetch_add(waveBytesEnd - waveBytesBegin, std::memory_order_relaxed);
+        }
+    }
+    
+    if (sweep->m_lod.pointCount() == 0) {
+        return S11Parser::ParseResult::EmptyFile;
+    }
+    
+    sweep->m_index.shrink_to_fit();
+    return Ptr(std::move(sweep));
+}
+
+size_t OutOfCoreSweep::residentBytes() const noexcept {
+    return m_lod.memoryBytes() + m_index.capacity() * sizeof(IndexEntry);
+}
+
+size_t OutOfCoreSweep::maxWindowPoints() const noexcept {
+    return m_memoryLimit / windowShare / windowBytesPerPoint;
+}
+
+std::pair<size_t, size_t> OutOfCoreSweep::pointRange(double freqMin, double freqMax) const {
+    if (!m_lod.isValid() || freqMax < freqMin) {
+        return {0, 0};
+    }
+    
+    // Диапазон точек по корзинам уровня 0: корзины, пересекающие окно, и по соседней точке
+    const auto base = m_lod.level(0);
+    const size_t bucketSize = m_lod.bucketSize();
+    const auto first = std::partition_point(base.begin(), base.end(), [freqMin](const LodPyramid::Bucket& bucket) {
+        return bucket.last.frequency < freqMin;
+    });
+    const auto last = std::partition_point(first, base.end(), [freqMax](const LodPyramid::Bucket& bucket) {
+        return bucket.first.frequency <= freqMax;
+    });
+    
+    const size_t firstBucket = static_cast<size_t>(first - base.begin());
+    const size_t lastBucket = static_cast<size_t>(last - base.begin());
+    const size_t begin = firstBucket > 0 ? firstBucket * bucketSize - 1 : 0;
+    const size_t end = std::min(lastBucket * bucketSize + 1, pointCount());
+    return {begin, std::max(begin, end)};
+}
+
+OutOfCoreSweep::Window OutOfCoreSweep::readPoints(size_t begin, size_t end) const {
+    PERF_MEASURE("OutOfCoreSweep::readPoints");
+    
+    // Ближайшая точка индекса не дальше begin, дальше разбор с пропуском
+    const auto entry = std::prev(std::partition_point(m_index.begin(), m_index.end(), [begin](const IndexEntry& item) {
+        return item.firstPoint <= begin;
+    }));
+    
+    S11Parser::ColumnBlock block;
+    S11Parser::parseRange(m_file.view().substr(entry->byteOffset), begin - entry->firstPoint, end - begin, block);
+    
+    Window window;
+    window.measurement = Measurement::fromColumns(std::move(block.frequency), std::move(block.real),
+                                                  std::move(block.imag));
+    window.lod = LodPyramid::build(window.measurement.frequencies(), window.measurement.logMagnitudes());
+    window.begin = begin;
+    window.end = begin + window.measurement.size();
+    return window;
+}
+
+std::optional<OutOfCoreSweep::Window> OutOfCoreSweep::readWindow(double freqMin, double freqMax) const {
+    PERF_MEASURE("OutOfCoreSweep::readWindow");
+    
+    const auto [begin, end] = pointRange(freqMin, freqMax);
+    if (begin >= end || end - begin > maxWindowPoints()) {
+        return std::nullopt;
+    }
+    return readPoints(begin, end);
+}
+
+OutOfCoreSweep::WindowPtr OutOfCoreSweep::renderWindow(double freqMin, double freqMax, int columns) const {
+    const auto [begin, end] = pointRange(freqMin, freqMax);
+    const size_t maxPoints = std::min(maxWindowPoints(), static_cast<size_t>(std::max(columns, 1)) * m_lod.bucketSize());
+    if (begin >= end || end - begin > maxPoints) {
+        return nullptr;
+    }
+    
+    std::lock_guard lock(m_windowMutex);
+    if (m_lastWindow && m_lastWindow->begin <= begin && end <= m_lastWindow->end) {
+        return m_lastWindow;
+    }
+    
+    // Запас по краям, пока окно укладывается в предел: небольшой сдвиг не требует чтения
+    PERF_MEASURE("OutOfCoreSweep::renderWindow");
+    const size_t slack = std::min((end - begin) / 2, (maxPoints - (end - begin)) / 2);
+    const size_t readBegin = begin - std::min(begin, slack);
+    const size_t readEnd = std::min(end + slack, pointCount());
+    m_lastWindow = std::make_shared<const Window>(readPoints(readBegin, readEnd));
+    return m_lastWindow;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Measurement.h"
+#include "LodPyramid.h"
+#include "MappedFile.h"
+#include "S11Parser.h"
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Файл, который не держится в памяти целиком. За один потоковый проход по
+// отображению строятся разреженный индекс смещений (начало блока разбора ->
+// номер первой точки) и LOD-пирамида; в памяти остаются только они, столбцы
+// точек не сохраняются. Пирамида огрубляется, а индекс прореживается так,
+// чтобы вместе уложиться в memoryLimit при любом размере файла.
+// Когда окно по частоте достаточно узкое, точки окна заново читаются из
+// отображения (readWindow). Частоты в файле должны идти по возрастанию.
+class OutOfCoreSweep {
+public:
+    static constexpr size_t defaultMemoryLimit = 512ull * 1024 * 1024;
+    
+    struct Options {
+        size_t memoryLimit = defaultMemoryLimit;
+        std::stop_token stopToken;
+        std::atomic<size_t>* bytesParsed = nullptr;
+    };
+    
+    // Точки окна в полном разрешении и пирамида по ним; [begin, end) — номера точек в файле
+    struct Window {
+        Measurement measurement;
+        LodPyramid lod;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    
+    using Ptr = std::shared_ptr<const OutOfCoreSweep>;
+    using WindowPtr = std::shared_ptr<const Window>;
+    using OpenExpected = std::variant<Ptr, S11Parser::ParseResult>;
+    
+    [[nodiscard]] static OpenExpected open(const std::filesystem::path& filePath, const Options& options);
+    
+    [[nodiscard]] const LodPyramid& lod() const noexcept { return m_lod; }
+    [[nodiscard]] size_t pointCount() const noexcept { return m_lod.pointCount(); }
+    [[nodiscard]] size_t memoryLimit() const noexcept { return m_memoryLimit; }
+    // Память под пирамиду и индекс
+    [[nodiscard]] size_t residentBytes() const noexcept;
+    // Больше этого окно не читается в полном разрешении
+    [[nodiscard]] size_t maxWindowPoints() const noexcept;
+    
+    // Точки с частотой в [freqMin, freqMax] и по соседу с краев;
+    // nullopt, если их больше maxWindowPoints(). Можно звать из нескольких потоков
+    [[nodiscard]] std::optional<Window> readWindow(double freqMin, double freqMax) const;
+    
+    // Окно для отрисовки шириной columns пикселей. Полное разрешение нужно, только
+    // пока на столбец приходится меньше корзины пирамиды, поэтому окно не больше
+    // columns * lod().bucketSize() точек; шире — nullptr, рисуется по пирамиде.
+    // Последнее окно запоминается: окно внутри него из файла не читается.
+    // Можно звать из нескольких потоков
+    [[nodiscard]] WindowPtr renderWindow(double freqMin, double freqMax, int columns) const;
+    
+private:
+    struct IndexEntry {
+        size_t byteOffset;
+        size_t firstPoint;
+    };
+    
+    // Номера точек [begin, end), пересекающих [freqMin, freqMax], по соседу с краев
+    [[nodiscard]] std::pair<size_t, size_t> pointRange(double freqMin, double freqMax) const;
+    [[nodiscard]] Window readPoints(size_t begin, size_t end) const;
+    
+    MappedFile m_file;
+    LodPyramid m_lod;
+    std::vector<IndexEntry> m_index;
+    size_t m_memoryLimit = defaultMemoryLimit;
+    
+    mutable std::mutex m_windowMutex;
+    mutable WindowPtr m_lastWindow;
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+// Трассировка и метрики производительности.
+//
+//   PERF_MEASURE("S11Parser::parseChunk");       // интервал до конца области видимости
+//   PERF_COUNTER("points", measurement.size());  // значение счетчика на шкале времени
+//   PERF_ASYNC_BEGIN("load", id) / PERF_ASYNC_END("load", id)  // интервал через потоки
+//
+// События пишутся в буфер своего потока (метки времени в нс от старта процесса)
+// и выгружаются в формат Chrome Trace Event JSON — открывается в chrome://tracing
+// и ui.perfetto.dev. Имена должны жить до выгрузки (строковые литералы).
+//
+// Без TOUCHSTONE_ENABLE_TRACING макросы раскрываются в пустоту, а сам
+// PerformanceTracer не компилируется.
+
+#ifdef TOUCHSTONE_ENABLE_TRACING
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class PerformanceTracer {
+public:
+    enum class EventType : char {
+        Complete = 'X',
+        Counter = 'C',
+        AsyncBegin = 'b',
+        AsyncEnd = 'e'
+    };
+    
+    struct Event {
+        const char* name;
+        uint64_t timestampNs;
+        // Complete — длительность в нс, Counter — значение, Async — идентификатор
+        uint64_t payload;
+        EventType type;
+    };
+    
+    // Сверх этого события потока отбрасываются и учитываются в droppedEvents()
+    static constexpr size_t maxEventsPerThread = 1 << 20;
+    
+    [[nodiscard]] static uint64_t nowNs() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch()).count());
+    }
+    
+    static void record(const char* name, EventType type, uint64_t timestampNs, uint64_t payload) {
+        ThreadBuffer& buffer = threadBuffer();
+        // Захват почти всегда без конкуренции: буфер делит поток только с выгрузкой
+        std::lock_guard lock(buffer.mutex);
+        if (buffer.events.size() >= maxEventsPerThread) {
+            ++buffer.dropped;
+            return;
+        }
+        buffer.events.push_back({name, timestampNs, payload, type});
+    }
+    
+    static void clear() {
+        std::lock_guard registryLock(registry().mutex);
+        for (const auto& buffer : registry().buffers) {
+            std::lock_guard lock(buffer->mutex);
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+    }
+    
+    [[nodiscard]] static uint64_t droppedEvents() {
+        uint64_t dropped = 0;
+        std::lock_guard registryLock(registry().mutex);
+        for (const auto& buffer : registry().buffers) {
+            std::lock_guard lock(buffer->mutex);
+            dropped += buffer->dropped;
+        }
+        return dropped;
+    }
+    
+    // Все события всех потоков в Chrome Trace Event JSON; ts и dur — в мкс
+    static bool writeChromeTrace(const std::filesystem::path& filePath) {
+        std::FILE* file = std::fopen(filePath.string().c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        
+        std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+        bool first = true;
+        
+        std::lock_guard registryLock(registry().mutex);
+        for (const auto& buffer : registry().buffers) {
+            std::lock_guard lock(buffer->mutex);
+            for (const Event& event : buffer->events) {
+                std::fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+                             first ? "" : ",", event.name, static_cast<char>(event.type), buffer->threadId,
+                             static_cast<double>(event.timestampNs) / 1000.0);
+                first = false;
+                
+                switch (event.type) {
+                    case EventType::Complete:
+                        std::fprintf(file, ",\"dur\":%.3f}", static_cast<double>(event.payload) / 1000.0);
+                        break;
+                    case EventType::Counter:
+                        std::fprintf(file, ",\"args\":{\"value\":%llu}}", static_cast<unsigned long long>(event.payload));
+                        break;
+                    case EventType::AsyncBegin:
+                    case EventType::AsyncEnd:
+                        std::fprintf(file, ",\"cat\":\"async\",\"id\":%llu}", static_cast<unsigned long long>(event.payload));
+                        break;
+                }
+            }
+        }
+        
+        std::fputs("\n]}\n", file);
+        return std::fclose(file) == 0;
+    }
+    
+private:
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        uint64_t dropped = 0;
+        unsigned threadId = 0;
+    };
+    
+    // Буферы живут в реестре и после завершения своих потоков
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    };
+    
+    static std::chrono::steady_clock::time_point epoch() noexcept {
+        static const auto start = std::chrono::steady_clock::now();
+        return start;
+    }
+    
+    static Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+    
+    static ThreadBuffer& threadBuffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+            auto created = std::make_shared<ThreadBuffer>();
+            created->events.reserve(4096);
+            std::lock_guard lock(registry().mutex);
+            created->threadId = static_cast<unsigned>(registry().buffers.size()) + 1;
+            registry().buffers.push_back(created);
+            return created;
+        }();
+        return *buffer;
+    }
+};
+
+// Интервал от конструктора до деструктора
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name) noexcept
+        : m_name(name), m_start(PerformanceTracer::nowNs()) {}
+    
+    ~ScopedTimer() {
+        PerformanceTracer::record(m_name, PerformanceTracer::EventType::Complete, m_start,
+                                  PerformanceTracer::nowNs() - m_start);
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    
+private:
+    const char* m_name;
+    uint64_t m_start;
+};
+
+#define PERF_CONCAT_IMPL(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_IMPL(a, b)
+
+#define PERF_MEASURE(name) ScopedTimer PERF_CONCAT(perfScope_, __LINE__)(name)
+#define PERF_COUNTER(name, value) \
+    PerformanceTracer::record(name, PerformanceTracer::EventType::Counter, PerformanceTracer::nowNs(), \
+                              static_cast<uint64_t>(value))
+#define PERF_ASYNC_BEGIN(name, id) \
+    PerformanceTracer::record(name, PerformanceTracer::EventType::AsyncBegin, PerformanceTracer::nowNs(), \
+                              static_cast<uint64_t>(id))
+#define PERF_ASYNC_END(name, id) \
+    PerformanceTracer::record(name, PerformanceTracer::EventType::AsyncEnd, PerformanceTracer::nowNs(), \
+                              static_cast<uint64_t>(id))
+#define PERF_WRITE_TRACE(path) PerformanceTracer::writeChromeTrace(path)
+
+#else
+
+#define PERF_MEASURE(name) ((void)0)
+#define PERF_COUNTER(name, value) ((void)0)
+#define PERF_ASYNC_BEGIN(name, id) ((void)0)
+#define PERF_ASYNC_END(name, id) ((void)0)
+#define PERF_WRITE_TRACE(path) ((void)0)
+
+#endif
@@ -0,0 +1,116 @@
+#include "PlotLayers.h"
+#include "PlotPainter.h"
+#include "PerformanceUtils.h"
+#include <QPainter>
+
+namespace {
+
+bool sameBounds(const GraphRenderer::GraphBounds& a, const GraphRenderer::GraphBounds& b) noexcept {
+    return a.minFreq == b.minFreq && a.maxFreq == b.maxFreq && a.minMag == b.minMag && a.maxMag == b.maxMag;
+}
+
+bool sameSurface(const QSize& size, qreal devicePixelRatio, const QSize& layerSize, qreal layerRatio) noexcept {
+    return size == layerSize && devicePixelRatio == layerRatio;
+}
+
+} // namespace
+
+QImage PlotLayers::makeLayerImage(const Inputs& inputs) {
+    QImage image(inputs.size * inputs.devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(inputs.devicePixelRatio);
+    image.fill(Qt::transparent);
+    return image;
+}
+
+QImage PlotLayers::compose(const Inputs& inputs) {
+    PERF_MEASURE("PlotLayers::compose");
+    
+    QImage frame(inputs.size * inputs.devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    frame.setDevicePixelRatio(inputs.devicePixelRatio);
+    frame.fill(Qt::white);
+    
+    const bool hasPrimary = !inputs.trace.empty();
+    const quint64 envelopeVersion = inputs.envelope ? inputs.envelope->version : 0;
+    if ((!hasPrimary && inputs.overlays.empty() && !inputs.envelope) ||
+        !PlotPainter::canDraw(inputs.bounds, inputs.size)) {
+        return frame;
+    }
+    
+    // Сетка
+    if (!m_grid.valid || !sameSurface(inputs.size, inputs.devicePixelRatio, m_grid.size, m_grid.devicePixelRatio)) {
+        PERF_MEASURE("PlotLayers::gridLayer");
+        m_grid.image = makeLayerImage(inputs);
+        QPainter painter(&m_grid.image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        PlotPainter::drawGrid(&painter, inputs.size);
+        
+        m_grid.size = inputs.size;
+        m_grid.devicePixelRatio = inputs.devicePixelRatio;
+        m_grid.valid = true;
+        m_gridRenders.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Оси и подписи
+    if (!m_axes.valid || !sameSurface(inputs.size, inputs.devicePixelRatio, m_axes.size, m_axes.devicePixelRatio) ||
+        !sameBounds(inputs.bounds, m_axes.bounds)) {
+        PERF_MEASURE("PlotLayers::axesLayer");
+        m_axes.image = makeLayerImage(inputs);
+        QPainter painter(&m_axes.image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        PlotPainter::drawAxes(&painter, inputs.bounds, inputs.size);
+        
+        m_axes.size = inputs.size;
+        m_axes.devicePixelRatio = inputs.devicePixelRatio;
+        m_axes.bounds = inputs.bounds;
+        m_axes.valid = true;
+        m_axesRenders.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Трасса
+    if (!m_trace.valid || !sameSurface(inputs.size, inputs.devicePixelRatio, m_trace.size, m_trace.devicePixelRatio) ||
+        !sameBounds(inputs.bounds, m_trace.bounds) || inputs.dataVersion != m_trace.dataVersion ||
+        inputs.overlayVersion != m_trace.overlayVersion || envelopeVersion != m_trace.envelopeVersion ||
+        inputs.maskVersion != m_trace.maskVersion || inputs.showAllPoints != m_trace.showAllPoints) {
+        PERF_MEASURE("PlotLayers::traceLayer");
+        m_trace.image = makeLayerImage(inputs);
+        QPainter painter(&m_trace.image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        if (inputs.maskResult) {
+            PlotPainter::drawMaskViolations(&painter, *inputs.maskResult, inputs.bounds, inputs.size);
+        }
+        if (inputs.envelope) {
+            PlotPainter::drawEnvelope(&painter, *inputs.envelope, inputs.bounds, inputs.size);
+        }
+        // Наложенные трассы под основной; каждая по своей пирамиде, поэтому
+        // цена слоя растет с числом трасс, а не с числом точек
+        for (const OverlayTrace& overlay : inputs.overlays) {
+            PlotPainter::drawTrace(&painter, overlay.parts, inputs.bounds, inputs.showAllPoints, inputs.size,
+                                   overlay.color);
+        }
+        if (hasPrimary) {
+            PlotPainter::drawTrace(&painter, inputs.trace, inputs.bounds, inputs.showAllPoints, inputs.size);
+        }
+        if (inputs.mask) {
+            PlotPainter::drawLimitMask(&painter, *inputs.mask, inputs.bounds, inputs.size);
+        }
+        
+        m_trace.size = inputs.size;
+        m_trace.devicePixelRatio = inputs.devicePixelRatio;
+        m_trace.bounds = inputs.bounds;
+        m_trace.dataVersion = inputs.dataVersion;
+        m_trace.overlayVersion = inputs.overlayVersion;
+        m_trace.envelopeVersion = envelopeVersion;
+        m_trace.maskVersion = inputs.maskVersion;
+        m_trace.showAllPoints = inputs.showAllPoints;
+        m_trace.valid = true;
+        m_traceRenders.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Порядок наложения как при прямой отрисовке: сетка, оси, трасса
+    QPainter painter(&frame);
+    painter.drawImage(0, 0, m_grid.image);
+    painter.drawImage(0, 0, m_axes.image);
+    painter.drawImage(0, 0, m_trace.image);
+    
+    return frame;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QColor>
+#include <QImage>
+#include <QSize>
+#include <atomic>
+#include <vector>
+#include "Measurement.h"
+#include "LodPyramid.h"
+#include "SweepStatistics.h"
+#include "LimitMask.h"
+#include "GraphRenderer.h"
+
+// Кэш слоев графика: сетка, оси с подписями и трасса рисуются в отдельные
+// прозрачные QImage и пересчитываются только при смене своих входов:
+//   сетка  — размер;
+//   оси    — размер и границы;
+//   трасса — размер, границы, данные, наложенные трассы, огибающая и маска.
+// Кадр собирается наложением слоев. Обращаться к compose() можно только
+// из одного потока одновременно; счетчики читаются из любого.
+class PlotLayers {
+public:
+    // Трасса другого файла поверх основной: свои точки и свои пирамиды
+    struct OverlayTrace {
+        std::vector<GraphRenderer::TracePart> parts;
+        QColor color;
+    };
+    
+    struct Inputs {
+        // Куски основной трассы; пусто, если на графике только наложенные
+        std::vector<GraphRenderer::TracePart> trace;
+        quint64 dataVersion = 0;
+        std::vector<OverlayTrace> overlays;
+        quint64 overlayVersion = 0;
+        // Статистика по свипам, рисуется под всеми трассами
+        const SweepStatistics::Envelope* envelope = nullptr;
+        // Маска допуска и нарушения основной трассы; версия меняется с любым из них
+        const LimitMask* mask = nullptr;
+        const LimitMask::Result* maskResult = nullptr;
+        quint64 maskVersion = 0;
+        GraphRenderer::GraphBounds bounds{};
+        bool showAllPoints = false;
+        QSize size;
+        qreal devicePixelRatio = 1.0;
+    };
+    
+    [[nodiscard]] QImage compose(const Inputs& inputs);
+    
+    // Сколько раз каждый слой действительно перерисовывался
+    [[nodiscard]] quint64 gridRenders() const noexcept { return m_gridRenders.load(std::memory_order_relaxed); }
+    [[nodiscard]] quint64 axesRenders() const noexcept { return m_axesRenders.load(std::memory_order_relaxed); }
+    [[nodiscard]] quint64 traceRenders() const noexcept { return m_traceRenders.load(std::memory_order_relaxed); }
+    
+private:
+    struct Layer {
+        QImage image;
+        QSize size;
+        qreal devicePixelRatio = 0.0;
+        GraphRenderer::GraphBounds bounds{};
+        quint64 dataVersion = 0;
+        quint64 overlayVersion = 0;
+        quint64 envelopeVersion = 0;
+        quint64 maskVersion = 0;
+        bool showAllPoints = false;
+        bool valid = false;
+    };
+    
+    static QImage makeLayerImage(const Inputs& inputs);
+    
+    Layer m_grid;
+    Layer m_axes;
+    Layer m_trace;
+    
+    std::atomic<quint64> m_gridRenders{0};
+    std::atomic<quint64> m_axesRenders{0};
+    std::atomic<quint64> m_traceRenders{0};
+};
@@ -0,0 +1,400 @@
+#include "PlotPainter.h"
+#include "PerformanceUtils.h"
+#include <QFont>
+#include <QPen>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+QImage PlotPainter::renderFrame(const Measurement& measurement, const LodPyramid& lod,
+                                const GraphRenderer::GraphBounds& bounds, bool showAllPoints,
+                                QSize size, qreal devicePixelRatio) {
+    PERF_MEASURE("PlotPainter::renderFrame");
+    
+    QImage image(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::white);
+    
+    if (!canDraw(bounds, size)) {
+        return image;
+    }
+    
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    
+    drawGrid(&painter, size);
+    drawAxes(&painter, bounds, size);
+    drawTrace(&painter, measurement, lod, bounds, showAllPoints, size);
+    
+    return image;
+}
+
+bool PlotPainter::canDraw(const GraphRenderer::GraphBounds& bounds, QSize size) noexcept {
+    const int plotWidth = size.width() - 2 * margin;
+    const int plotHeight = size.height() - 2 * margin;
+    
+    return plotWidth > 0 && plotHeight > 0 &&
+           bounds.maxFreq - bounds.minFreq > 0 && bounds.maxMag - bounds.minMag > 0;
+}
+
+void PlotPainter::drawGrid(QPainter *painter, QSize size) {
+    const int width = size.width();
+    const int height = size.height();
+    const int plotWidth = width - 2 * margin;
+    const int plotHeight = height - 2 * margin;
+    
+    const QPen gridPen(Qt::lightGray, 1, Qt::DotLine);
+    painter->setPen(gridPen);
+    
+    // X
+    for (int i = 1; i < 10; ++i) {
+        const int x = margin + i * plotWidth / 10;
+        painter->drawLine(x, margin, x, height - margin);
+    }
+    
+    // Y
+    for (int i = 1; i < 10; ++i) {
+        const int y = margin + i * plotHeight / 10;
+        painter->drawLine(margin, y, width - margin, y);
+    }
+}
+
+void PlotPainter::drawAxes(QPainter *painter, const GraphRenderer::GraphBounds& bounds, QSize size) {
+    const int width = size.width();
+    const int height = size.height();
+    const int plotWidth = width - 2 * margin;
+    const int plotHeight = height - 2 * margin;
+    
+    // Отрисовка осей
+    const QPen axisPen(Qt::black, 2);
+    painter->setPen(axisPen);
+    painter->drawLine(margin, height - margin, width - margin, height - margin); // X
+    painter->drawLine(margin, margin, margin, height - margin); // Y
+    
+    // Подпись осей
+    painter->setPen(Qt::black);
+    QFont font = painter->font();
+    font.setPointSize(10);
+    painter->setFont(font);
+    
+    painter->drawText(width/2 - 30, height - 10, "Frequency (Hz)");
+    
+    painter->save();
+    painter->translate(15, height/2);
+    painter->rotate(-90);
+    painter->drawText(-40, 0, "|S11| (dB)");
+    painter->restore();
+    
+    // Подпись значений на осях
+    constexpr int numTicks = 5;
+    const double freqStep = (bounds.maxFreq - bounds.minFreq) / numTicks;
+    const double magStep = (bounds.maxMag - bounds.minMag) / numTicks;
+    
+    // X
+    for (int i = 0; i <= numTicks; ++i) {
+        const double freq = bounds.minFreq + i * freqStep;
+        const int x = margin + i * plotWidth / numTicks;
+        
+        QString freqStr = formatFrequency(freq);
+        painter->drawText(x - 20, height - margin + 20, freqStr);
+    }
+    
+    // Y
+    for (int i = 0; i <= numTicks; ++i) {
+        const double mag = bounds.minMag + i * magStep;
+        const int y = height - margin - i * plotHeight / numTicks;
+        
+        const QString magStr = QString::number(mag, 'f', 1);
+        painter->drawText(5, y + 5, magStr);
+    }
+}
+
+QColor PlotPainter::traceColor(size_t index) {
+    if (index == 0) {
+        return Qt::blue;
+    }
+    // Хорошо различимые на белом цвета, по кругу
+    static const QColor palette[] = {
+        QColor(214, 39, 40), QColor(44, 160, 44), QColor(255, 127, 14), QColor(148, 103, 189),
+        QColor(23, 190, 207), QColor(140, 86, 75), QColor(227, 119, 194), QColor(127, 127, 127),
+    };
+    return palette[(index - 1) % std::size(palette)];
+}
+
+void PlotPainter::drawTrace(QPainter *painter, const Measurement& measurement, const LodPyramid& lod,
+                            const GraphRenderer::GraphBounds& bounds, bool showAllPoints, QSize size,
+                            const QColor& color) {
+    const GraphRenderer::TracePart part{&measurement, &lod};
+    drawTrace(painter, std::span(&part, 1), bounds, showAllPoints, size, color);
+}
+
+void PlotPainter::drawTrace(QPainter *painter, std::span<const GraphRenderer::TracePart> parts,
+                            const GraphRenderer::GraphBounds& bounds, bool showAllPoints, QSize size,
+                            const QColor& color) {
+    PERF_MEASURE("PlotPainter::drawTrace");
+    
+    const int width = size.width();
+    const int height = size.height();
+    
+    const QPen dataPen(color, 2);
+    painter->setPen(dataPen);
+    
+    const double freqRange = bounds.maxFreq - bounds.minFreq;
+    const double magRange = bounds.maxMag - bounds.minMag;
+    const double plotWidth = width - 2 * margin;
+    const double plotHeight = height - 2 * margin;
+    
+    const double invFreqRange = 1.0 / freqRange;
+    const double invMagRange = 1.0 / magRange;
+    
+    // Отрисовка графика с помощью кривой QPainterPath
+    QPainterPath path;
+    bool firstPoint = true;
+    
+    const auto addPathPoint = [&](double frequency, double magnitude) {
+        const double x = margin + (frequency - bounds.minFreq) * invFreqRange * plotWidth;
+        const double y = height - margin - (magnitude - bounds.minMag) * invMagRange * plotHeight;
+        
+        // Сжатие, если одна из точек вышла за границы
+        const double clampedX = std::clamp(x, -1000.0, static_cast<double>(width + 1000));
+        const double clampedY = std::clamp(y, -1000.0, static_cast<double>(height + 1000));
+        
+        const QPointF pixelPoint(clampedX, clampedY);
+        
+        if (firstPoint) {
+            path.moveTo(pixelPoint);
+            firstPoint = false;
+        } else {
+            path.lineTo(pixelPoint);
+        }
+    };
+    
+    // Куски вне окна пропускаются, кроме ближайших с каждой стороны: до них идет линия
+    struct VisiblePart {
+        const GraphRenderer::TracePart* part;
+        size_t begin;
+        size_t end;
+    };
+    thread_local std::vector<VisiblePart> visibleParts;
+    visibleParts.clear();
+    
+    size_t dataSize = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        const auto& lod = *parts[i].lod;
+        if (parts.size() > 1 && lod.isValid()) {
+            const bool nextLeft = i + 1 < parts.size() && parts[i + 1].lod->isValid() &&
+                                  parts[i + 1].lod->root().last.frequency < bounds.minFreq;
+            const bool previousRight = i > 0 && parts[i - 1].lod->isValid() &&
+                                       parts[i - 1].lod->root().first.frequency > bounds.maxFreq;
+            if (nextLeft || previousRight) {
+                continue;
+            }
+        }
+        
+        // Только точки внутри окна по частоте и по одному соседу с краев
+        const auto [visibleBegin, visibleEnd] = parts[i].measurement->visibleRange(bounds.minFreq, bounds.maxFreq);
+        visibleParts.push_back({&parts[i], visibleBegin, visibleEnd});
+        dataSize += visibleEnd - visibleBegin;
+    }
+    const int columns = std::max(1, static_cast<int>(plotWidth));
+    
+    // Буфер M4-точек переиспользуется между кадрами одного потока
+    thread_local std::vector<LodPyramid::Sample> lodSamples;
+    
+    for (const VisiblePart& visible : visibleParts) {
+        const Measurement& measurement = *visible.part->measurement;
+        const LodPyramid& lod = *visible.part->lod;
+        const auto frequencies = measurement.frequencies();
+        const auto magnitudes = measurement.logMagnitudes();
+        
+        // M4 по пирамиде: не больше 4 точек на пиксельный столбец, экстремумы сохраняются
+        if (lod.isValid() && lod.query(bounds.minFreq, bounds.maxFreq, columns, lodSamples, frequencies, magnitudes)) {
+            for (const auto& sample : lodSamples) {
+                addPathPoint(sample.frequency, sample.value);
+            }
+        } else if (dataSize > 1000) {
+            // Аппроксимация, если точек много
+            const size_t step = std::max(size_t(1), dataSize / 2000);
+            
+            for (size_t i = visible.begin; i < visible.end; i += step) {
+                addPathPoint(frequencies[i], magnitudes[i]);
+            }
+        } else {
+            for (size_t i = visible.begin; i < visible.end; ++i) {
+                addPathPoint(frequencies[i], magnitudes[i]);
+            }
+        }
+    }
+    
+    painter->drawPath(path);
+    
+    // Отрисовка точек. При зуме кружки рисуются, только пока на точку приходится
+    // не меньше 4 пиксельных столбцов: иначе они сливаются в линию, а их число
+    // росло бы с числом точек в окне, а не с шириной графика
+    if (dataSize < 500 || (showAllPoints && dataSize <= static_cast<size_t>(columns) / 4)) {
+        painter->setBrush(color);
+        
+        for (const VisiblePart& visible : visibleParts) {
+            const auto frequencies = visible.part->measurement->frequencies();
+            const auto magnitudes = visible.part->measurement->logMagnitudes();
+            
+            for (size_t i = visible.begin; i < visible.end; ++i) {
+                const double x = margin + (frequencies[i] - bounds.minFreq) * invFreqRange * plotWidth;
+                const double y = height - margin - (magnitudes[i] - bounds.minMag) * invMagRange * plotHeight;
+                
+                if (x >= margin && x <= width - margin && y >= margin && y <= height - margin) {
+                    const QPointF pixelPoint(x, y);
+                    painter->drawEllipse(pixelPoint, 2, 2);
+                }
+            }
+        }
+    }
+}
+
+void PlotPainter::drawEnvelope(QPainter *painter, const SweepStatistics::Envelope& envelope,
+                               const GraphRenderer::GraphBounds& bounds, QSize size) {
+    PERF_MEASURE("PlotPainter::drawEnvelope");
+    
+    const int width = size.width();
+    const int height = size.height();
+    const double plotWidth = width - 2 * margin;
+    const double plotHeight = height - 2 * margin;
+    const double invFreqRange = 1.0 / (bounds.maxFreq - bounds.minFreq);
+    const double invMagRange = 1.0 / (bounds.maxMag - bounds.minMag);
+    
+    const auto toX = [&](double frequency) {
+        return std::clamp(margin + (frequency - bounds.minFreq) * invFreqRange * plotWidth,
+                          -1000.0, static_cast<double>(width + 1000));
+    };
+    const auto toY = [&](double magnitude) {
+        return std::clamp(height - margin - (magnitude - bounds.minMag) * invMagRange * plotHeight,
+                          -1000.0, static_cast<double>(height + 1000));
+    };
+    
+    // Крайние значения по пиксельному столбцу: цена не зависит от густоты сетки
+    struct Column {
+        double x;
+        double low, high;
+        double sigmaLow, sigmaHigh;
+        double meanLow, meanHigh;
+    };
+    thread_local std::vector<Column> columns;
+    columns.clear();
+    
+    const auto [begin, end] = envelope.visibleRange(bounds.minFreq, bounds.maxFreq);
+    long long currentColumn = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const double x = toX(envelope.frequency[i]);
+        const long long column = static_cast<long long>(std::floor(x));
+        const double mean = envelope.mean[i];
+        const double sigma = envelope.stdDev[i];
+        
+        if (columns.empty() || column != currentColumn) {
+            columns.push_back({x, envelope.min[i], envelope.max[i], mean - sigma, mean + sigma, mean, mean});
+            currentColumn = column;
+            continue;
+        }
+        Column& current = columns.back();
+        current.low = std::min(current.low, envelope.min[i]);
+        current.high = std::max(current.high, envelope.max[i]);
+        current.sigmaLow = std::min(current.sigmaLow, mean - sigma);
+        current.sigmaHigh = std::max(current.sigmaHigh, mean + sigma);
+        current.meanLow = std::min(current.meanLow, mean);
+        current.meanHigh = std::max(current.meanHigh, mean);
+    }
+    if (columns.empty()) {
+        return;
+    }
+    
+    // Полоса: верхняя граница слева направо, нижняя обратно
+    const auto band = [&](auto lower, auto upper) {
+        QPolygonF polygon;
+        polygon.reserve(static_cast<qsizetype>(columns.size() * 2));
+        for (const Column& column : columns) {
+            polygon.append(QPointF(column.x, toY(upper(column))));
+        }
+        for (auto it = columns.rbegin(); it != columns.rend(); ++it) {
+            polygon.append(QPointF(it->x, toY(lower(*it))));
+        }
+        return polygon;
+    };
+    
+    const QColor color(0, 128, 128);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(color.red(), color.green(), color.blue(), 40));
+    painter->drawPolygon(band([](const Column& c) { return c.low; }, [](const Column& c) { return c.high; }));
+    painter->setBrush(QColor(color.red(), color.green(), color.blue(), 90));
+    painter->drawPolygon(band([](const Column& c) { return c.sigmaLow; }, [](const Column& c) { return c.sigmaHigh; }));
+    
+    QPolygonF meanLine;
+    meanLine.reserve(static_cast<qsizetype>(columns.size() * 2));
+    for (const Column& column : columns) {
+        meanLine.append(QPointF(column.x, toY(column.meanHigh)));
+        if (column.meanLow != column.meanHigh) {
+            meanLine.append(QPointF(column.x, toY(column.meanLow)));
+        }
+    }
+    painter->setBrush(Qt::NoBrush);
+    painter->setPen(QPen(color, 1.5));
+    painter->drawPolyline(meanLine);
+}
+
+void PlotPainter::drawMaskViolations(QPainter *painter, const LimitMask::Result& result,
+                                     const GraphRenderer::GraphBounds& bounds, QSize size) {
+    const double plotWidth = size.width() - 2 * margin;
+    const double invFreqRange = 1.0 / (bounds.maxFreq - bounds.minFreq);
+    const auto toX = [&](double frequency) {
+        return std::clamp(margin + (frequency - bounds.minFreq) * invFreqRange * plotWidth,
+                          static_cast<double>(margin), static_cast<double>(size.width() - margin));
+    };
+    
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(220, 0, 0, 50));
+    for (const LimitMask::Violation& violation : result.violations) {
+        if (violation.highFrequency < bounds.minFreq || violation.lowFrequency > bounds.maxFreq) {
+            continue;
+        }
+        // Участок из одной точки тоже должен быть виден
+        const double left = toX(violation.lowFrequency);
+        const double right = std::max(toX(violation.highFrequency), left + 2.0);
+        painter->drawRect(QRectF(left - 1.0, margin, right - left + 1.0, size.height() - 2 * margin));
+    }
+}
+
+void PlotPainter::drawLimitMask(QPainter *painter, const LimitMask& mask,
+                                const GraphRenderer::GraphBounds& bounds, QSize size) {
+    const double plotWidth = size.width() - 2 * margin;
+    const double plotHeight = size.height() - 2 * margin;
+    const double invFreqRange = 1.0 / (bounds.maxFreq - bounds.minFreq);
+    const double invMagRange = 1.0 / (bounds.maxMag - bounds.minMag);
+    const auto toPoint = [&](double frequency, double magnitude) {
+        return QPointF(margin + (frequency - bounds.minFreq) * invFreqRange * plotWidth,
+                       size.height() - margin - (magnitude - bounds.minMag) * invMagRange * plotHeight);
+    };
+    
+    painter->save();
+    painter->setClipRect(QRectF(margin, margin, plotWidth, plotHeight));
+    painter->setBrush(Qt::NoBrush);
+    for (const LimitMask::Segment& segment : mask.segments()) {
+        const bool upper = segment.kind == LimitMask::Kind::Upper;
+        painter->setPen(QPen(upper ? QColor(200, 0, 0) : QColor(230, 130, 0), 2, Qt::DashLine));
+        painter->drawLine(toPoint(segment.startFrequency, segment.startLimitDb),
+                          toPoint(segment.stopFrequency, segment.stopLimitDb));
+    }
+    painter->restore();
+}
+
+QString PlotPainter::formatFrequency(double freq) {
+    if (freq >= 1e9) {
+        return QString::number(freq / 1e9, 'f', 1) + "G";   // Гига
+    } else if (freq >= 1e6) {
+        return QString::number(freq / 1e6, 'f', 1) + "M";   // Мега
+    } else if (freq >= 1e3) {
+        return QString::number(freq / 1e3, 'f', 1) + "k";   // Кило
+    } else {
+        return QString::number(freq, 'f', 0);
+    }
+}
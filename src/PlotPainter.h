@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QSize>
+#include <QString>
+#include "Measurement.h"
+#include "LodPyramid.h"
+#include "SweepStatistics.h"
+#include "LimitMask.h"
+#include "GraphRenderer.h"
+
+// Отрисовка графика без привязки к виджету: можно звать из рабочего потока
+// и рисовать в QImage. Все методы работают только с переданными данными.
+class PlotPainter {
+public:
+    static constexpr int margin = 60;
+    
+    // Кадр целиком; size — в логических пикселях
+    static QImage renderFrame(const Measurement& measurement, const LodPyramid& lod,
+                              const GraphRenderer::GraphBounds& bounds, bool showAllPoints,
+                              QSize size, qreal devicePixelRatio);
+    
+    static void drawGrid(QPainter *painter, QSize size);
+    static void drawAxes(QPainter *painter, const GraphRenderer::GraphBounds& bounds, QSize size);
+    static void drawTrace(QPainter *painter, const Measurement& measurement, const LodPyramid& lod,
+                          const GraphRenderer::GraphBounds& bounds, bool showAllPoints, QSize size,
+                          const QColor& color = Qt::blue);
+    // Трасса из кусков одной линией: рисуются куски, попавшие в окно, и по соседнему с краев
+    static void drawTrace(QPainter *painter, std::span<const GraphRenderer::TracePart> parts,
+                          const GraphRenderer::GraphBounds& bounds, bool showAllPoints, QSize size,
+                          const QColor& color = Qt::blue);
+    
+    // Статистика по свипам: полоса min..max, полоса среднее ± СКО и линия среднего.
+    // Точки сетки сводятся к крайним значениям по пиксельным столбцам
+    static void drawEnvelope(QPainter *painter, const SweepStatistics::Envelope& envelope,
+                             const GraphRenderer::GraphBounds& bounds, QSize size);
+    
+    // Маска допуска: участки нарушений — полупрозрачные красные полосы под трассами,
+    // отрезки границ — штриховые линии поверх трасс
+    static void drawMaskViolations(QPainter *painter, const LimitMask::Result& result,
+                                   const GraphRenderer::GraphBounds& bounds, QSize size);
+    static void drawLimitMask(QPainter *painter, const LimitMask& mask,
+                              const GraphRenderer::GraphBounds& bounds, QSize size);
+    
+    // Цвет трассы по номеру файла в выборке; 0 — основная трасса
+    [[nodiscard]] static QColor traceColor(size_t index);
+    
+    static QString formatFrequency(double freq);
+    
+    [[nodiscard]] static bool canDraw(const GraphRenderer::GraphBounds& bounds, QSize size) noexcept;
+};
@@ -0,0 +1,235 @@
+#include "Resampler.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Точек сетки в блоке: индексы и доли блока лежат в L1
+constexpr size_t blockPoints = 512;
+constexpr size_t minChunkPoints = 64 * 1024;
+constexpr size_t maxChannels = 2;
+
+using Method = Resampler::Method;
+using Extrapolation = Resampler::Extrapolation;
+
+// Наклон между точками a и b; на повторе частоты — 0
+inline double slope(const double* f, const double* y, size_t a, size_t b) noexcept {
+    const double span = f[b] - f[a];
+    return span > 0.0 ? (y[b] - y[a]) / span : 0.0;
+}
+
+// Совместный проход: для каждой точки блока — интервал [f[j], f[j + 1]] и доля t в нем.
+// j — курсор по входу, переходит из блока в блок
+void locate(const double* f, size_t n, const double* grid, size_t count, size_t& j, size_t* index, double* t) {
+    for (size_t k = 0; k < count; ++k) {
+        const double x = grid[k];
+        while (j + 2 < n && f[j + 1] < x) {
+            ++j;
+        }
+        index[k] = j;
+        const double span = f[j + 1] - f[j];
+        // Повтор частоты (нулевой шаг) — без деления на ноль
+        t[k] = span > 0.0 ? (x - f[j]) / span : 1.0;
+    }
+}
+
+void interpolateLinear(const double* y, const size_t* index, const double* t, size_t count, double* out) noexcept {
+    for (size_t k = 0; k < count; ++k) {
+        const size_t j = index[k];
+        out[k] = y[j] + t[k] * (y[j + 1] - y[j]);
+    }
+}
+
+void interpolateCubic(const double* f, const double* y, size_t n,
+                      const size_t* index, const double* t, size_t count, double* out) noexcept {
+    for (size_t k = 0; k < count; ++k) {
+        const size_t j = index[k];
+        // Соседи для касательных; на краях — односторонние разности
+        const size_t previous = j > 0 ? j - 1 : j;
+        const size_t next = j + 2 < n ? j + 2 : j + 1;
+        const double h = f[j + 1] - f[j];
+        const double m0 = slope(f, y, previous, j + 1) * h;
+        const double m1 = slope(f, y, j, next) * h;
+        
+        const double s = t[k];
+        const double s2 = s * s;
+        const double s3 = s2 * s;
+        out[k] = (2.0 * s3 - 3.0 * s2 + 1.0) * y[j] + (s3 - 2.0 * s2 + s) * m0 +
+                 (3.0 * s2 - 2.0 * s3) * y[j + 1] + (s3 - s2) * m1;
+    }
+}
+
+struct Columns {
+    const double* in[maxChannels] = {};
+    double* out[maxChannels] = {};
+    size_t count = 0;
+};
+
+// Точки сетки вне диапазона свипа: [0, begin) и [end, grid.size())
+void extrapolate(std::span<const double> f, const Columns& columns, std::span<const double> grid,
+                 size_t begin, size_t end, Extrapolation extrapolation) {
+    const size_t n = f.size();
+    for (size_t c = 0; c < columns.count; ++c) {
+        const double* y = columns.in[c];
+        double* out = columns.out[c];
+        
+        if (extrapolation == Extrapolation::NaN) {
+            std::fill(out, out + begin, std::numeric_limits<double>::quiet_NaN());
+            std::fill(out + end, out + grid.size(), std::numeric_limits<double>::quiet_NaN());
+            continue;
+        }
+        
+        // Hold — нулевой наклон; у свипа из одной точки наклона нет
+        const bool linear = extrapolation == Extrapolation::Linear && n > 1;
+        const double lowSlope = linear ? slope(f.data(), y, 0, 1) : 0.0;
+        const double highSlope = linear ? slope(f.data(), y, n - 2, n - 1) : 0.0;
+        for (size_t i = 0; i < begin; ++i) {
+            out[i] = y[0] + lowSlope * (grid[i] - f[0]);
+        }
+        for (size_t i = end; i < grid.size(); ++i) {
+            out[i] = y[n - 1] + highSlope * (grid[i] - f[n - 1]);
+        }
+    }
+}
+
+// Точки сетки [begin, end) внутри диапазона свипа, n >= 2
+void interpolateChunk(std::span<const double> f, const Columns& columns, std::span<const double> grid,
+                      size_t begin, size_t end, Method method) {
+    const size_t n = f.size();
+    // Начало блока — двоичным поиском, дальше курсор идет вместе с сеткой
+    const size_t first = static_cast<size_t>(std::lower_bound(f.begin(), f.end(), grid[begin]) - f.begin());
+    size_t j = std::min(first > 0 ? first - 1 : 0, n - 2);
+    
+    size_t index[blockPoints];
+    double t[blockPoints];
+    for (size_t blockBegin = begin; blockBegin < end; blockBegin += blockPoints) {
+        const size_t count = std::min(blockPoints, end - blockBegin);
+        locate(f.data(), n, grid.data() + blockBegin, count, j, index, t);
+        for (size_t c = 0; c < columns.count; ++c) {
+            if (method == Method::Cubic) {
+                interpolateCubic(f.data(), columns.in[c], n, index, t, count, columns.out[c] + blockBegin);
+            } else {
+                interpolateLinear(columns.in[c], index, t, count, columns.out[c] + blockBegin);
+            }
+        }
+    }
+}
+
+bool resampleColumns(std::span<const double> frequency, const Columns& columns,
+                     std::span<const double> grid, const Resampler::Options& options) {
+    PERF_MEASURE("Resampler::resample");
+    
+    const size_t n = frequency.size();
+    if (n == 0) {
+        return false;
+    }
+    
+    const auto [begin, end] = Resampler::coveredRange(frequency, grid);
+    extrapolate(frequency, columns, grid, begin, end, options.extrapolation);
+    
+    // Свип из одной точки покрывает только свою частоту
+    if (n == 1) {
+        for (size_t c = 0; c < columns.count; ++c) {
+            std::fill(columns.out[c] + begin, columns.out[c] + end, columns.in[c][0]);
+        }
+        return true;
+    }
+    
+    const size_t covered = end - begin;
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunkCount = grid.size() >= options.parallelThreshold
+        ? std::clamp(covered / minChunkPoints, size_t(1), threads * 4)
+        : size_t(1);
+    
+    if (chunkCount == 1) {
+        if (covered > 0) {
+            interpolateChunk(frequency, columns, grid, begin, end, options.method);
+        }
+        return true;
+    }
+    
+    // Только номера блоков, по одному на блок
+    std::vector<size_t> chunks(chunkCount);
+    std::iota(chunks.begin(), chunks.end(), size_t(0));
+    std::for_each(
+        std::execution::par,
+        chunks.begin(), chunks.end(),
+        [&](size_t chunk) {
+            interpolateChunk(frequency, columns, grid,
+                             begin + covered * chunk / chunkCount,
+                             begin + covered * (chunk + 1) / chunkCount,
+                             options.method);
+        }
+    );
+    return true;
+}
+
+} // namespace
+
+std::pair<size_t, size_t> Resampler::coveredRange(std::span<const double> frequency,
+                                                  std::span<const double> grid) noexcept {
+    if (frequency.empty()) {
+        return {0, 0};
+    }
+    const auto first = std::lower_bound(grid.begin(), grid.end(), frequency.front());
+    const auto last = std::upper_bound(first, grid.end(), frequency.back());
+    return {static_cast<size_t>(first - grid.begin()), static_cast<size_t>(last - grid.begin())};
+}
+
+bool Resampler::resample(std::span<const double> frequency,
+                         std::span<const double> real,
+                         std::span<const double> imag,
+                         std::span<const double> grid,
+                         std::span<double> outReal,
+                         std::span<double> outImag,
+                         const Options& options) {
+    if (real.size() != frequency.size() || imag.size() != frequency.size() ||
+        outReal.size() != grid.size() || outImag.size() != grid.size()) {
+        return false;
+    }
+    
+    Columns columns;
+    columns.in[0] = real.data();
+    columns.in[1] = imag.data();
+    columns.out[0] = outReal.data();
+    columns.out[1] = outImag.data();
+    columns.count = 2;
+    return resampleColumns(frequency, columns, grid, options);
+}
+
+bool Resampler::resample(std::span<const double> frequency,
+                         std::span<const double> values,
+                         std::span<const double> grid,
+                         std::span<double> out,
+                         const Options& options) {
+    if (values.size() != frequency.size() || out.size() != grid.size()) {
+        return false;
+    }
+    
+    Columns columns;
+    columns.in[0] = values.data();
+    columns.out[0] = out.data();
+    columns.count = 1;
+    return resampleColumns(frequency, columns, grid, options);
+}
+
+Measurement Resampler::resample(const Measurement& measurement, std::span<const double> grid, const Options& options) {
+    if (measurement.empty()) {
+        return {};
+    }
+    if (!measurement.isSortedByFrequency()) {
+        Measurement sorted = measurement;
+        sorted.sortByFrequency();
+        return resample(sorted, grid, options);
+    }
+    
+    std::vector<double> real(grid.size());
+    std::vector<double> imag(grid.size());
+    resample(measurement.frequencies(), measurement.realParts(), measurement.imagParts(), grid, real, imag, options);
+    return Measurement::fromColumns(std::vector<double>(grid.begin(), grid.end()), std::move(real), std::move(imag));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Measurement.h"
+#include <cstddef>
+#include <span>
+#include <utility>
+
+// Перенос свипа на общую сетку частот для сравнения, усреднения и масок.
+// Re и Im интерполируются независимо (комплексная интерполяция по компонентам).
+// Входные частоты и сетка должны быть отсортированы по возрастанию.
+// Сетка обходится блоками: сначала одним совместным проходом по обоим массивам
+// для блока находятся индексы интервалов и доли t, затем значения считаются
+// циклом без ветвлений, который векторизуется. Блоки сетки независимы
+// и при большом числе точек считаются параллельно; начало каждого блока
+// находится двоичным поиском.
+class Resampler {
+public:
+    enum class Method {
+        // Отрезками между соседними точками
+        Linear,
+        // Кубический Эрмит с касательными по центральным разностям (на краях — односторонним);
+        // проходит через исходные точки, на неравномерной сетке не выбрасывает
+        Cubic
+    };
+    
+    // Что выдавать для точек сетки вне [frequency.front(), frequency.back()]
+    enum class Extrapolation {
+        // NaN — точка не покрыта свипом
+        NaN,
+        // Крайнее значение свипа
+        Hold,
+        // Продолжение крайнего отрезка
+        Linear
+    };
+    
+    struct Options {
+        Method method = Method::Linear;
+        Extrapolation extrapolation = Extrapolation::NaN;
+        // Меньше точек сетки — в одном потоке; SIZE_MAX — всегда в одном
+        size_t parallelThreshold = 256 * 1024;
+    };
+    
+    // Комплексные столбцы. false — размеры столбцов или выходов не совпадают либо свип пуст
+    static bool resample(std::span<const double> frequency,
+                         std::span<const double> real,
+                         std::span<const double> imag,
+                         std::span<const double> grid,
+                         std::span<double> outReal,
+                         std::span<double> outImag,
+                         const Options& options);
+    
+    // Один вещественный столбец (например, |S11| дБ)
+    static bool resample(std::span<const double> frequency,
+                         std::span<const double> values,
+                         std::span<const double> grid,
+                         std::span<double> out,
+                         const Options& options);
+    
+    // Измерение на сетке; неотсортированное сортируется в копии. Пустое — пустой результат
+    [[nodiscard]] static Measurement resample(const Measurement& measurement,
+                                              std::span<const double> grid,
+                                              const Options& options);
+    
+    // Полуинтервал индексов точек сетки внутри [frequency.front(), frequency.back()]
+    [[nodiscard]] static std::pair<size_t, size_t> coveredRange(std::span<const double> frequency,
+                                                                std::span<const double> grid) noexcept;
+};
@@ -1,11 +1,21 @@
 #include "S11Parser.h"
-#include <fstream>
+#include "MappedFile.h"
+#include "SimdScanner.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <array>
 #include <cctype>
 #include <charconv>
 #include <execution>
+#include <thread>
 
 S11Parser::ParseResult S11Parser::parseFile(const std::string& filePath, Measurement& measurement) {
-    auto result = parseFileExpected(filePath);
+    return parseFile(filePath, measurement, ParseOptions{});
+}
+
+S11Parser::ParseResult S11Parser::parseFile(const std::string& filePath, Measurement& measurement,
+                                            const ParseOptions& options) {
+    auto result = parseFileExpected(filePath, nullptr, options);
     if (std::holds_alternative<Measurement>(result)) {
         measurement = std::move(std::get<Measurement>(result));
         return ParseResult::Success;
@@ -13,32 +23,78 @@ S11Parser::ParseResult S11Parser::parseFile(const std::string& filePath, Measure
     return std::get<ParseResult>(result);
 }
 
-S11Parser::ParseExpected S11Parser::parseFileExpected(const std::filesystem::path& filePath) {
+S11Parser::ParseExpected S11Parser::parseFileExpected(const std::filesystem::path& filePath, ParseStats* stats) {
+    return parseFileExpected(filePath, stats, ParseOptions{});
+}
+
+S11Parser::ParseExpected S11Parser::parseFileExpected(const std::filesystem::path& filePath, ParseStats* stats,
+                                                      const ParseOptions& options) {
+    PERF_MEASURE("S11Parser::parseFile");
+    
     if (!std::filesystem::exists(filePath)) {
         return ParseResult::FileNotFound;
     }
     
-    const auto fileSize = std::filesystem::file_size(filePath);
-    constexpr size_t parallelThreshold = 1024 * 1024; // 1mb
+    MappedFile file;
+    {
+        PERF_MEASURE("S11Parser::map");
+        if (!file.open(filePath)) {
+            return ParseResult::FileNotFound;
+        }
+    }
     
-    if (fileSize > parallelThreshold) {
-        return parseFileParallel(filePath);
+    if (stats) {
+        stats->bytesRead = file.size();
+        stats->bytesCopied = file.bytesCopied();
+        stats->memoryMapped = file.isMapped();
     }
     
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        return ParseResult::FileNotFound;
+    const size_t parallelThreshold = options.parallelThreshold;
+    
+    if (options.stopToken.stop_requested()) {
+        return ParseResult::Cancelled;
+    }
+    
+    // Маленький файл разбирается одним блоком
+    auto result = file.size() <= parallelThreshold ? parseBuffer(file.view())
+                : options.onBlock ? parseBufferStreaming(file.view(), options)
+                : parseBufferParallel(file.view(), options);
+    if (file.size() <= parallelThreshold) {
+        if (options.bytesParsed) {
+            options.bytesParsed->fetch_add(file.size(), std::memory_order_relaxed);
+        }
+        if (auto* measurement = std::get_if<Measurement>(&result); measurement && options.onBlock) {
+            options.onBlock(measurement->frequencies(), measurement->realParts(), measurement->imagParts());
+        }
     }
     
+    if (options.stopToken.stop_requested()) {
+        return ParseResult::Cancelled;
+    }
+    
+    // Дальше везде предполагается порядок по частоте (бинарный поиск, LOD)
+    if (auto* measurement = std::get_if<Measurement>(&result); measurement && !measurement->isSortedByFrequency()) {
+        PERF_MEASURE("S11Parser::sortByFrequency");
+        measurement->sortByFrequency();
+    }
+    
+    return result;
+}
+
+S11Parser::ParseExpected S11Parser::parseBuffer(std::string_view content) {
+    PERF_MEASURE("S11Parser::parseBuffer");
+    
     Measurement measurement;
-    std::string line;
     bool headerFound = false;
     
-    const size_t estimatedLines = fileSize / 50;
+    const size_t estimatedLines = content.size() / 50;
     measurement.reserve(estimatedLines);
     
-    while (std::getline(file, line)) {
-        const auto trimmedLine = trim(line);
+    const char* const end = content.data() + content.size();
+    for (const char* lineStart = content.data(); lineStart < end; ) {
+        const char* lineEnd = SimdScanner::findNewline(lineStart, end);
+        const auto trimmedLine = trim(std::string_view(lineStart, static_cast<size_t>(lineEnd - lineStart)));
+        lineStart = lineEnd + 1;
         
         if (trimmedLine.empty()) {
             continue;
@@ -71,61 +127,155 @@ S11Parser::ParseExpected S11Parser::parseFileExpected(const std::filesystem::pat
     return measurement;
 }
 
-S11Parser::ParseExpected S11Parser::parseFileParallel(const std::filesystem::path& filePath) {
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        return ParseResult::FileNotFound;
+// Диапазоны байт по числу ядер, границы выровнены по '\n'.
+// Блок не больше maxChunkBytes, чтобы отмена и прогресс срабатывали часто
+std::vector<std::string_view> S11Parser::splitIntoChunks(std::string_view content, size_t maxChunkBytes) {
+    constexpr size_t minChunkBytes = 256 * 1024;
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t maxChunks = std::max(threads * 4, (content.size() + maxChunkBytes - 1) / maxChunkBytes);
+    const size_t chunkCount = std::clamp(content.size() / minChunkBytes, size_t(1), maxChunks);
+    
+    std::vector<std::string_view> chunks;
+    chunks.reserve(chunkCount);
+    
+    const char* const end = content.data() + content.size();
+    const char* chunkStart = content.data();
+    for (size_t i = 1; i <= chunkCount && chunkStart < end; ++i) {
+        const char* chunkEnd = end;
+        if (i < chunkCount) {
+            const char* target = content.data() + content.size() * i / chunkCount;
+            const char* newline = SimdScanner::findNewline(std::max(target, chunkStart), end);
+            chunkEnd = newline == end ? end : newline + 1;
+        }
+        chunks.emplace_back(chunkStart, static_cast<size_t>(chunkEnd - chunkStart));
+        chunkStart = chunkEnd;
     }
     
-    std::string content((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
+    return chunks;
+}
+
+void S11Parser::parseChunk(std::string_view chunk, ColumnBlock& block) {
+    PERF_MEASURE("S11Parser::parseChunk");
     
-    std::vector<std::string_view> lineVector;
-    size_t start = 0;
-    for (size_t i = 0; i <= content.size(); ++i) {
-        if (i == content.size() || content[i] == '\n') {
-            if (i > start) {
-                lineVector.emplace_back(content.data() + start, i - start);
-            }
-            start = i + 1;
+    const char* const end = chunk.data() + chunk.size();
+    
+    // Верхняя оценка числа точек, чтобы блок не перевыделялся
+    const size_t maxPoints = SimdScanner::countNewlines(chunk.data(), end) + 1;
+    block.frequency.reserve(maxPoints);
+    block.real.reserve(maxPoints);
+    block.imag.reserve(maxPoints);
+    
+    for (const char* lineStart = chunk.data(); lineStart < end; ) {
+        const char* lineEnd = SimdScanner::findNewline(lineStart, end);
+        const auto trimmedLine = trim(std::string_view(lineStart, static_cast<size_t>(lineEnd - lineStart)));
+        lineStart = lineEnd + 1;
+        
+        if (trimmedLine.empty() || trimmedLine[0] == '#' || trimmedLine[0] == '!') {
+            continue;
+        }
+        
+        if (auto point = parseDataLine(trimmedLine)) {
+            block.frequency.push_back(point->frequency);
+            block.real.push_back(point->s11.real());
+            block.imag.push_back(point->s11.imag());
         }
     }
+}
+
+void S11Parser::parseRange(std::string_view text, size_t skipPoints, size_t maxPoints, ColumnBlock& block) {
+    PERF_MEASURE("S11Parser::parseRange");
     
-    std::vector<std::optional<FrequencyPoint>> points(lineVector.size());
-    bool headerFound = false;
+    block.frequency.reserve(block.frequency.size() + maxPoints);
+    block.real.reserve(block.real.size() + maxPoints);
+    block.imag.reserve(block.imag.size() + maxPoints);
     
-    const size_t headerCheckLimit = std::min(lineVector.size(), size_t(10));
-    for (size_t i = 0; i < headerCheckLimit; ++i) {
-        const auto trimmedLine = trim(lineVector[i]);
-        if (!trimmedLine.empty() && trimmedLine[0] == '#') {
-            if (isValidHeader(trimmedLine)) {
-                headerFound = true;
-                break;
+    // Пропущенные строки тоже разбираются: точкой считается только корректная строка данных
+    const char* const end = text.data() + text.size();
+    for (const char* lineStart = text.data(); lineStart < end && maxPoints > 0; ) {
+        const char* lineEnd = SimdScanner::findNewline(lineStart, end);
+        const auto trimmedLine = trim(std::string_view(lineStart, static_cast<size_t>(lineEnd - lineStart)));
+        lineStart = lineEnd + 1;
+        
+        if (trimmedLine.empty() || trimmedLine[0] == '#' || trimmedLine[0] == '!') {
+            continue;
+        }
+        
+        if (auto point = parseDataLine(trimmedLine)) {
+            if (skipPoints > 0) {
+                --skipPoints;
+                continue;
             }
+            block.frequency.push_back(point->frequency);
+            block.real.push_back(point->s11.real());
+            block.imag.push_back(point->s11.imag());
+            --maxPoints;
         }
     }
+}
+
+// Заголовок ищется среди первых 10 непустых строк
+bool S11Parser::hasHeader(std::string_view content) noexcept {
+    const char* const end = content.data() + content.size();
+    size_t linesChecked = 0;
+    for (const char* lineStart = content.data(); lineStart < end && linesChecked < 10; ) {
+        const char* lineEnd = SimdScanner::findNewline(lineStart, end);
+        const auto trimmedLine = trim(std::string_view(lineStart, static_cast<size_t>(lineEnd - lineStart)));
+        if (lineEnd > lineStart) {
+            ++linesChecked;
+        }
+        lineStart = lineEnd + 1;
+        
+        if (!trimmedLine.empty() && trimmedLine[0] == '#' && isValidHeader(trimmedLine)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+S11Parser::ParseExpected S11Parser::parseBufferParallel(std::string_view content, const ParseOptions& options) {
+    PERF_MEASURE("S11Parser::parseBufferParallel");
+    
+    const bool headerFound = hasHeader(content);
+    
+    struct Block {
+        std::string_view text;
+        ColumnBlock columns;
+        size_t offset = 0;
+    };
+    
+    std::vector<Block> blocks;
+    constexpr size_t maxChunkBytes = 8 * 1024 * 1024;
+    for (const auto chunk : splitIntoChunks(content, maxChunkBytes)) {
+        blocks.push_back({chunk, {}, 0});
+    }
     
-    std::transform(
-        std::execution::par_unseq,
-        lineVector.begin(), lineVector.end(),
-        points.begin(),
-        [](std::string_view line) -> std::optional<FrequencyPoint> {
-            const auto trimmedLine = trim(line);
-            if (trimmedLine.empty() || trimmedLine[0] == '#' || trimmedLine[0] == '!') {
-                return std::nullopt;
+    std::for_each(
+        std::execution::par,
+        blocks.begin(), blocks.end(),
+        [&options](Block& block) {
+            if (options.stopToken.stop_requested()) {
+                return;
+            }
+            parseChunk(block.text, block.columns);
+            if (options.bytesParsed) {
+                options.bytesParsed->fetch_add(block.text.size(), std::memory_order_relaxed);
             }
-            return parseDataLine(trimmedLine);
         }
     );
     
-    Measurement measurement;
-    for (const auto& point : points) {
-        if (point) {
-            measurement.addPoint(point->frequency, point->s11);
-        }
+    // Разобранные блоки освобождаются вместе с blocks при выходе
+    if (options.stopToken.stop_requested()) {
+        return ParseResult::Cancelled;
     }
     
-    if (measurement.empty()) {
+    // Префиксная сумма размеров блоков -> смещения в итоговом массиве
+    size_t totalPoints = 0;
+    for (auto& block : blocks) {
+        block.offset = totalPoints;
+        totalPoints += block.columns.frequency.size();
+    }
+    
+    if (totalPoints == 0) {
         return ParseResult::EmptyFile;
     }
     
@@ -133,14 +283,108 @@ S11Parser::ParseExpected S11Parser::parseFileParallel(const std::filesystem::pat
         return ParseResult::InvalidFormat;
     }
     
-    return measurement;
+    // Столбцы собираются по одному, блоки освобождаются сразу после копирования,
+    // поэтому пиковая память около 4/3 от итоговой
+    const auto gatherColumn = [&blocks, totalPoints](std::vector<double> ColumnBlock::* column) {
+        PERF_MEASURE("S11Parser::gatherColumn");
+        std::vector<double> result(totalPoints);
+        std::for_each(
+            std::execution::par,
+            blocks.begin(), blocks.end(),
+            [&result, column](Block& block) {
+                auto& source = block.columns.*column;
+                std::copy(source.begin(), source.end(), result.begin() + block.offset);
+                source = {};
+            }
+        );
+        return result;
+    };
+    
+    auto frequency = gatherColumn(&ColumnBlock::frequency);
+    auto real = gatherColumn(&ColumnBlock::real);
+    auto imag = gatherColumn(&ColumnBlock::imag);
+    
+    return Measurement::fromColumns(std::move(frequency), std::move(real), std::move(imag));
+}
+
+// Волны по числу потоков из небольших блоков: каждая волна разбирается
+// параллельно, дописывается в итоговые столбцы и сразу отдается в onBlock
+S11Parser::ParseExpected S11Parser::parseBufferStreaming(std::string_view content, const ParseOptions& options) {
+    PERF_MEASURE("S11Parser::parseBufferStreaming");
+    
+    // Без заголовка точки не показываются; ошибку вернет обычный разбор
+    if (!hasHeader(content)) {
+        return parseBufferParallel(content, options);
+    }
+    
+    constexpr size_t streamChunkBytes = 1024 * 1024;
+    const auto chunks = splitIntoChunks(content, streamChunkBytes);
+    const size_t waveSize = std::max(1u, std::thread::hardware_concurrency());
+    
+    std::vector<double> frequency;
+    std::vector<double> real;
+    std::vector<double> imag;
+    
+    std::vector<ColumnBlock> blocks;
+    for (size_t waveBegin = 0; waveBegin < chunks.size(); waveBegin += waveSize) {
+        if (options.stopToken.stop_requested()) {
+            return ParseResult::Cancelled;
+        }
+        
+        PERF_MEASURE("S11Parser::parseWave");
+        const size_t waveEnd = std::min(waveBegin + waveSize, chunks.size());
+        blocks.assign(waveEnd - waveBegin, {});
+        std::for_each(
+            std::execution::par,
+            blocks.begin(), blocks.end(),
+            [&blocks, &chunks, &options, waveBegin](ColumnBlock& block) {
+                const auto& chunk = chunks[waveBegin + static_cast<size_t>(&block - blocks.data())];
+                parseChunk(chunk, block);
+                if (options.bytesParsed) {
+                    options.bytesParsed->fetch_add(chunk.size(), std::memory_order_relaxed);
+                }
+            }
+        );
+        
+        const size_t waveOffset = frequency.size();
+        for (const auto& block : blocks) {
+            frequency.insert(frequency.end(), block.frequency.begin(), block.frequency.end());
+            real.insert(real.end(), block.real.begin(), block.real.end());
+            imag.insert(imag.end(), block.imag.begin(), block.imag.end());
+        }
+        
+        // После первой волны емкость резервируется по средней длине строки
+        if (waveBegin == 0 && !frequency.empty()) {
+            size_t waveBytes = 0;
+            for (size_t i = waveBegin; i < waveEnd; ++i) {
+                waveBytes += chunks[i].size();
+            }
+            const size_t estimate = content.size() / std::max<size_t>(1, waveBytes / frequency.size()) * 21 / 20;
+            frequency.reserve(estimate);
+            real.reserve(estimate);
+            imag.reserve(estimate);
+        }
+        
+        if (frequency.size() > waveOffset) {
+            const size_t count = frequency.size() - waveOffset;
+            options.onBlock(std::span<const double>(frequency).subspan(waveOffset, count),
+                            std::span<const double>(real).subspan(waveOffset, count),
+                            std::span<const double>(imag).subspan(waveOffset, count));
+        }
+    }
+    
+    if (frequency.empty()) {
+        return ParseResult::EmptyFile;
+    }
+    
+    return Measurement::fromColumns(std::move(frequency), std::move(real), std::move(imag));
 }
 
 bool S11Parser::isValidHeader(std::string_view line) noexcept {
     //# Hz S RI R 50
-    const auto tokens = split(line, ' ');
+    std::array<std::string_view, 6> tokens;
     
-    if (tokens.size() < 6) {
+    if (SimdScanner::splitFields(line, tokens.data(), tokens.size()) < tokens.size()) {
         return false;
     }
     
@@ -152,10 +396,10 @@ bool S11Parser::isValidHeader(std::string_view line) noexcept {
 }
 
 std::optional<FrequencyPoint> S11Parser::parseDataLine(std::string_view line) noexcept {
-    const auto tokens = split(line, ' ');
+    std::array<std::string_view, 3> tokens;
     
     // freq r i
-    if (tokens.size() != 3) {
+    if (SimdScanner::splitFields(line, tokens.data(), tokens.size()) != tokens.size()) {
         return std::nullopt;
     }
     
@@ -179,26 +423,6 @@ std::optional<FrequencyPoint> S11Parser::parseDataLine(std::string_view line) no
     return FrequencyPoint{frequency, std::complex<double>(real_part, imag_part)};
 }
 
-std::vector<std::string_view> S11Parser::split(std::string_view str, char delimiter) noexcept {
-    std::vector<std::string_view> tokens;
-    
-    size_t start = 0;
-    for (size_t i = 0; i <= str.size(); ++i) {
-        if (i == str.size() || str[i] == delimiter) {
-            if (i > start) {
-                const auto token = str.substr(start, i - start);
-                const auto trimmed = trim(token);
-                if (!trimmed.empty()) {
-                    tokens.push_back(trimmed);
-                }
-            }
-            start = i + 1;
-        }
-    }
-    
-    return tokens;
-}
-
 constexpr std::string_view S11Parser::trim(std::string_view str) noexcept {
     constexpr auto whitespace = " \t\r\n";
     
@@ -1,11 +1,16 @@
 #pragma once
 
 #include "Measurement.h"
+#include <atomic>
+#include <stop_token>
 #include <string>
 #include <string_view>
 #include <filesystem>
+#include <functional>
+#include <span>
 #include <optional>
 #include <variant>
+#include <vector>
 
 class S11Parser {
 public:
@@ -13,18 +18,68 @@ public:
         Success,
         FileNotFound,
         InvalidFormat,
-        EmptyFile
+        EmptyFile,
+        Cancelled,
+        UnsortedFrequencies
+    };
+    
+    // Статистика ввода: bytesCopied == 0 означает, что данные разбирались прямо из mmap
+    struct ParseStats {
+        size_t bytesRead = 0;
+        size_t bytesCopied = 0;
+        bool memoryMapped = false;
+    };
+    
+    // Точки очередной порции файла, по столбцам
+    using BlockCallback = std::function<void(std::span<const double> frequency,
+                                             std::span<const double> real,
+                                             std::span<const double> imag)>;
+    
+    // Файлы не больше этого разбираются одним блоком в вызывающем потоке
+    static constexpr size_t defaultParallelThreshold = 1024 * 1024;
+    
+    // Отмена и прогресс. Обе проверяются на границах блоков разбора;
+    // bytesParsed (если задан) увеличивается на размер каждого разобранного блока.
+    // Если задан onBlock, файл разбирается волнами и каждая волна сразу
+    // передается в onBlock в порядке файла (из потока разбора).
+    // parallelThreshold позволяет выбрать путь явно (бенчмарки): 0 — всегда
+    // параллельно, SIZE_MAX — всегда одним блоком
+    struct ParseOptions {
+        std::stop_token stopToken;
+        std::atomic<size_t>* bytesParsed = nullptr;
+        BlockCallback onBlock;
+        size_t parallelThreshold = defaultParallelThreshold;
     };
     
     using ParseExpected = std::variant<Measurement, ParseResult>;
     
     static ParseResult parseFile(const std::string& filePath, Measurement& measurement);
-    static ParseExpected parseFileExpected(const std::filesystem::path& filePath);
+    static ParseResult parseFile(const std::string& filePath, Measurement& measurement,
+                                 const ParseOptions& options);
+    static ParseExpected parseFileExpected(const std::filesystem::path& filePath, ParseStats* stats = nullptr);
+    static ParseExpected parseFileExpected(const std::filesystem::path& filePath, ParseStats* stats,
+                                           const ParseOptions& options);
+    
+    // Результат разбора одного диапазона байт, по столбцам
+    struct ColumnBlock {
+        std::vector<double> frequency;
+        std::vector<double> real;
+        std::vector<double> imag;
+    };
+    
+    // Разбор по частям для загрузчиков, которые не держат файл в памяти целиком.
+    // Границы блоков splitIntoChunks выровнены по строкам, с них можно начинать parseRange
+    static bool hasHeader(std::string_view content) noexcept;
+    static std::vector<std::string_view> splitIntoChunks(std::string_view content, size_t maxChunkBytes);
+    static void parseChunk(std::string_view chunk, ColumnBlock& block);
+    // Точки text начиная с skipPoints-й (считая с нуля), не больше maxPoints
+    static void parseRange(std::string_view text, size_t skipPoints, size_t maxPoints, ColumnBlock& block);
     
 private:
     static bool isValidHeader(std::string_view line) noexcept;
     static std::optional<FrequencyPoint> parseDataLine(std::string_view line) noexcept;
-    static std::vector<std::string_view> split(std::string_view str, char delimiter) noexcept;
     static constexpr std::string_view trim(std::string_view str) noexcept;
-    static ParseExpected parseFileParallel(const std::filesystem::path& filePath);
+    static ParseExpected parseBuffer(std::string_view content);
+    static ParseExpected parseBufferParallel(std::string_view content, const ParseOptions& options);
+    static ParseExpected parseBufferStreaming(std::string_view content, const ParseOptions& options);
 };
@@ -0,0 +1,245 @@
+#include "SimdScanner.h"
+#include "CpuFeatures.h"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#ifdef TOUCHSTONE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using FindNewlineFn = const char* (*)(const char*, const char*) noexcept;
+using CountNewlinesFn = size_t (*)(const char*, const char*) noexcept;
+using SplitFieldsFn = size_t (*)(std::string_view, std::string_view*, size_t) noexcept;
+
+// Состояние разбора полей, общее для всех реализаций
+struct FieldState {
+    std::string_view line;
+    std::string_view* fields;
+    size_t maxFields;
+    size_t count = 0;
+    size_t fieldStart = 0;
+    bool inField = false;
+
+    // false, если полей уже больше maxFields
+    bool emit(size_t end) noexcept {
+        if (count < maxFields) {
+            fields[count] = line.substr(fieldStart, end - fieldStart);
+        }
+        ++count;
+        inField = false;
+        return count <= maxFields;
+    }
+};
+
+// Обработка блока по битовой маске пробельных символов (бит i -> байт pos + i)
+inline bool consumeMask(FieldState& state, uint64_t whitespace, size_t pos, unsigned width) noexcept {
+    const uint64_t blockMask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    uint64_t nonWhitespace = ~whitespace & blockMask;
+
+    while (true) {
+        if (!state.inField) {
+            if (nonWhitespace == 0) {
+                return true;
+            }
+            const unsigned i = static_cast<unsigned>(std::countr_zero(nonWhitespace));
+            state.fieldStart = pos + i;
+            state.inField = true;
+            whitespace &= ~((uint64_t(1) << i) - 1);
+        } else {
+            if (whitespace == 0) {
+                return true;
+            }
+            const unsigned j = static_cast<unsigned>(std::countr_zero(whitespace));
+            if (!state.emit(pos + j)) {
+                return false;
+            }
+            nonWhitespace &= ~((uint64_t(1) << j) - 1);
+        }
+    }
+}
+
+// Хвост строки и скалярная реализация
+inline size_t finishScalar(FieldState& state, size_t pos) noexcept {
+    const auto line = state.line;
+    for (; pos < line.size(); ++pos) {
+        const bool ws = SimdScanner::isWhitespace(line[pos]);
+        if (state.inField && ws) {
+            if (!state.emit(pos)) {
+                return state.count;
+            }
+        } else if (!state.inField && !ws) {
+            state.fieldStart = pos;
+            state.inField = true;
+        }
+    }
+    if (state.inField) {
+        state.emit(line.size());
+    }
+    return state.count;
+}
+
+const char* findNewlineScalar(const char* begin, const char* end) noexcept {
+    const void* found = std::memchr(begin, '\n', static_cast<size_t>(end - begin));
+    return found ? static_cast<const char*>(found) : end;
+}
+
+size_t countNewlinesScalar(const char* begin, const char* end) noexcept {
+    size_t count = 0;
+    for (const char* p = begin; p < end; ++p) {
+        count += (*p == '\n');
+    }
+    return count;
+}
+
+size_t splitFieldsScalar(std::string_view line, std::string_view* fields, size_t maxFields) noexcept {
+    FieldState state{line, fields, maxFields};
+    return finishScalar(state, 0);
+}
+
+#ifdef TOUCHSTONE_X86
+
+const char* findNewlineSse2(const char* begin, const char* end) noexcept {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        if (mask != 0) {
+            return p + std::countr_zero(static_cast<unsigned>(mask));
+        }
+    }
+    return findNewlineScalar(p, end);
+}
+
+size_t countNewlinesSse2(const char* begin, const char* end) noexcept {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+        count += static_cast<size_t>(std::popcount(mask));
+    }
+    return count + countNewlinesScalar(p, end);
+}
+
+size_t splitFieldsSse2(std::string_view line, std::string_view* fields, size_t maxFields) noexcept {
+    FieldState state{line, fields, maxFields};
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    size_t pos = 0;
+    for (; pos + 16 <= line.size(); pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line.data() + pos));
+        const __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(block, lf)));
+        const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(ws));
+        if (!consumeMask(state, mask, pos, 16)) {
+            return state.count;
+        }
+    }
+    return finishScalar(state, pos);
+}
+
+TOUCHSTONE_TARGET_AVX2
+const char* findNewlineAvx2(const char* begin, const char* end) noexcept {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+        if (mask != 0) {
+            return p + std::countr_zero(mask);
+        }
+    }
+    return findNewlineSse2(p, end);
+}
+
+TOUCHSTONE_TARGET_AVX2
+size_t countNewlinesAvx2(const char* begin, const char* end) noexcept {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+        count += static_cast<size_t>(std::popcount(mask));
+    }
+    return count + countNewlinesScalar(p, end);
+}
+
+TOUCHSTONE_TARGET_AVX2
+size_t splitFieldsAvx2(std::string_view line, std::string_view* fields, size_t maxFields) noexcept {
+    FieldState state{line, fields, maxFields};
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+
+    size_t pos = 0;
+    for (; pos + 32 <= line.size(); pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line.data() + pos));
+        const __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(block, lf)));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+        if (!consumeMask(state, mask, pos, 32)) {
+            return state.count;
+        }
+    }
+    return finishScalar(state, pos);
+}
+
+#endif
+
+struct Dispatch {
+    SimdScanner::Level level = SimdScanner::Level::Scalar;
+    FindNewlineFn findNewline = findNewlineScalar;
+    CountNewlinesFn countNewlines = countNewlinesScalar;
+    SplitFieldsFn splitFields = splitFieldsScalar;
+
+    Dispatch() noexcept {
+#ifdef TOUCHSTONE_X86
+        if (CpuFeatures::hasAvx2()) {
+            level = SimdScanner::Level::AVX2;
+            findNewline = findNewlineAvx2;
+            countNewlines = countNewlinesAvx2;
+            splitFields = splitFieldsAvx2;
+        } else if (CpuFeatures::hasSse2()) {
+            level = SimdScanner::Level::SSE2;
+            findNewline = findNewlineSse2;
+            countNewlines = countNewlinesSse2;
+            splitFields = splitFieldsSse2;
+        }
+#endif
+    }
+};
+
+const Dispatch& dispatch() noexcept {
+    static const Dispatch instance;
+    return instance;
+}
+
+} // namespace
+
+SimdScanner::Level SimdScanner::activeLevel() noexcept {
+    return dispatch().level;
+}
+
+const char* SimdScanner::findNewline(const char* begin, const char* end) noexcept {
+    return dispatch().findNewline(begin, end);
+}
+
+size_t SimdScanner::countNewlines(const char* begin, const char* end) noexcept {
+    return dispatch().countNewlines(begin, end);
+}
+
+size_t SimdScanner::splitFields(std::string_view line, std::string_view* fields, size_t maxFields) noexcept {
+    return dispatch().splitFields(line, fields, maxFields);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Поиск строк и полей в тексте Touchstone без аллокаций.
+// Реализация (AVX2 / SSE2 / скалярная) выбирается один раз при запуске.
+class SimdScanner {
+public:
+    enum class Level {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    [[nodiscard]] static Level activeLevel() noexcept;
+
+    // Первый '\n' в [begin, end) или end
+    [[nodiscard]] static const char* findNewline(const char* begin, const char* end) noexcept;
+
+    // Количество '\n' в [begin, end)
+    [[nodiscard]] static size_t countNewlines(const char* begin, const char* end) noexcept;
+
+    // Разбивает строку на поля по пробелам и табуляции.
+    // В fields записывается не больше maxFields полей; возвращаемое значение
+    // не превышает maxFields + 1, этого достаточно для проверки числа полей.
+    static size_t splitFields(std::string_view line, std::string_view* fields, size_t maxFields) noexcept;
+
+    [[nodiscard]] static constexpr bool isWhitespace(char c) noexcept {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+};
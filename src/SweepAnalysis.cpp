@@ -0,0 +1,80 @@
+#include "SweepAnalysis.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+[[nodiscard]] inline double power(std::span<const double> real, std::span<const double> imag, size_t i) noexcept {
+    return real[i] * real[i] + imag[i] * imag[i];
+}
+
+// Частота, на которой |S11| дБ между точками inside (не выше уровня) и outside проходит уровень
+[[nodiscard]] double crossing(std::span<const double> frequency, std::span<const double> real,
+                              std::span<const double> imag, size_t inside, size_t outside, double levelDb) noexcept {
+    const double insideDb = logMagnitudeDb(real[inside], imag[inside]);
+    const double outsideDb = logMagnitudeDb(real[outside], imag[outside]);
+    if (!(outsideDb > insideDb)) {
+        return frequency[inside];
+    }
+    
+    const double t = std::clamp((levelDb - insideDb) / (outsideDb - insideDb), 0.0, 1.0);
+    return frequency[inside] + t * (frequency[outside] - frequency[inside]);
+}
+
+} // namespace
+
+SweepAnalysis::Metrics SweepAnalysis::analyze(const Measurement& measurement, double bandLevelDb) {
+    return analyze(measurement.frequencies(), measurement.realParts(), measurement.imagParts(), bandLevelDb);
+}
+
+SweepAnalysis::Metrics SweepAnalysis::analyze(std::span<const double> frequency,
+                                              std::span<const double> real,
+                                              std::span<const double> imag,
+                                              double bandLevelDb) {
+    PERF_MEASURE("SweepAnalysis::analyze");
+    
+    Metrics metrics;
+    metrics.pointCount = frequency.size();
+    if (frequency.empty()) {
+        return metrics;
+    }
+    
+    // Первая точка с наименьшей |S11|^2
+    size_t minIndex = 0;
+    double minPower = power(real, imag, 0);
+    for (size_t i = 1; i < frequency.size(); ++i) {
+        const double p = power(real, imag, i);
+        if (p < minPower) {
+            minPower = p;
+            minIndex = i;
+        }
+    }
+    metrics.minS11Db = logMagnitudeDb(real[minIndex], imag[minIndex]);
+    metrics.minS11Frequency = frequency[minIndex];
+    
+    if (!(metrics.minS11Db <= bandLevelDb)) {
+        return metrics;
+    }
+    
+    // Сравнение в линейной мощности: |S11| дБ <= L  <=>  |S11|^2 <= 10^(L/10)
+    const double levelPower = std::pow(10.0, bandLevelDb / 10.0);
+    
+    size_t low = minIndex;
+    while (low > 0 && power(real, imag, low - 1) <= levelPower) {
+        --low;
+    }
+    size_t high = minIndex;
+    while (high + 1 < frequency.size() && power(real, imag, high + 1) <= levelPower) {
+        ++high;
+    }
+    
+    Band band;
+    band.clippedLow = low == 0;
+    band.clippedHigh = high + 1 == frequency.size();
+    band.lowFrequency = band.clippedLow ? frequency[low] : crossing(frequency, real, imag, low, low - 1, bandLevelDb);
+    band.highFrequency = band.clippedHigh ? frequency[high]
+                                          : crossing(frequency, real, imag, high, high + 1, bandLevelDb);
+    metrics.band = band;
+    return metrics;
+}
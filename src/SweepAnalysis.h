@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Measurement.h"
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <span>
+
+// Сводные характеристики свипа S11 для пакетной обработки:
+// минимум |S11| (точка наилучшего согласования, максимальные потери на отражение)
+// и полоса по уровню — непрерывный участок вокруг минимума, где |S11| не выше
+// заданного уровня (по умолчанию -10 дБ). Края полосы интерполируются линейно
+// в дБ между соседними точками. Частоты должны быть отсортированы.
+class SweepAnalysis {
+public:
+    static constexpr double defaultBandLevelDb = -10.0;
+    
+    struct Band {
+        double lowFrequency = 0.0;
+        double highFrequency = 0.0;
+        // Полоса уперлась в край измеренного диапазона и может быть шире
+        bool clippedLow = false;
+        bool clippedHigh = false;
+        
+        [[nodiscard]] double width() const noexcept { return highFrequency - lowFrequency; }
+    };
+    
+    struct Metrics {
+        size_t pointCount = 0;
+        double minS11Db = std::numeric_limits<double>::quiet_NaN();
+        double minS11Frequency = std::numeric_limits<double>::quiet_NaN();
+        // nullopt, если минимум выше уровня полосы
+        std::optional<Band> band;
+    };
+    
+    [[nodiscard]] static Metrics analyze(const Measurement& measurement, double bandLevelDb = defaultBandLevelDb);
+    
+    // Один проход по |S11|^2 без логарифма на каждую точку: log10 берется
+    // только для минимума и точек пересечения уровня
+    [[nodiscard]] static Metrics analyze(std::span<const double> frequency,
+                                         std::span<const double> real,
+                                         std::span<const double> imag,
+                                         double bandLevelDb = defaultBandLevelDb);
+};
@@ -0,0 +1,373 @@
+#include "SweepCache.h"
+#include "MappedFile.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr char fileMagic[8] = {'T', 'S', 'S', 'W', 'E', 'E', 'P', '\0'};
+constexpr uint32_t byteOrderMark = 0x01020304;
+constexpr const char* entryExtension = ".sweep";
+
+// Хэш содержимого: файл целиком, если он небольшой, иначе hashWindows окон
+// по hashWindowBytes, равномерно от начала до конца
+constexpr size_t hashWindows = 16;
+constexpr size_t hashWindowBytes = 64 * 1024;
+
+// Все поля по 8 байт после magic, поэтому столбцы за заголовком выровнены
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t contentHash;
+    uint64_t pathBytes;
+    uint64_t pointCount;
+    uint64_t bucketSize;
+    uint64_t levelCount;
+};
+
+static_assert(sizeof(FileHeader) % sizeof(double) == 0);
+static_assert(sizeof(LodPyramid::Bucket) == 8 * sizeof(double));
+
+constexpr size_t alignTo8(size_t bytes) noexcept {
+    return (bytes + 7) & ~size_t(7);
+}
+
+uint64_t mixHash(uint64_t hash, uint64_t value) noexcept {
+    hash ^= value;
+    hash *= 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 32);
+}
+
+uint64_t hashBytes(std::string_view data, uint64_t hash) noexcept {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        hash = mixHash(hash, word);
+    }
+    for (; i < data.size(); ++i) {
+        hash = mixHash(hash, static_cast<unsigned char>(data[i]));
+    }
+    return mixHash(hash, data.size());
+}
+
+uint64_t contentHash(std::string_view content) noexcept {
+    if (content.size() <= hashWindows * hashWindowBytes) {
+        return hashBytes(content, 0);
+    }
+    
+    uint64_t hash = 0;
+    const size_t lastOffset = content.size() - hashWindowBytes;
+    for (size_t i = 0; i < hashWindows; ++i) {
+        const size_t offset = lastOffset * i / (hashWindows - 1);
+        hash = hashBytes(content.substr(offset, hashWindowBytes), hash);
+    }
+    return hash;
+}
+
+template<typename T>
+void writeSpan(std::ofstream& out, std::span<const T> data) {
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size_bytes()));
+}
+
+// Последовательное чтение из отображенного файла с проверкой границ
+class Reader {
+public:
+    explicit Reader(std::string_view data) noexcept : m_data(data) {}
+    
+    template<typename T>
+    bool read(std::span<T> out) noexcept {
+        const size_t bytes = out.size_bytes();
+        if (bytes > m_data.size() - m_offset) {
+            return false;
+        }
+        std::memcpy(out.data(), m_data.data() + m_offset, bytes);
+        m_offset += bytes;
+        return true;
+    }
+    
+    bool skip(size_t bytes) noexcept {
+        if (bytes > m_data.size() - m_offset) {
+            return false;
+        }
+        m_offset += bytes;
+        return true;
+    }
+    
+    [[nodiscard]] std::string_view peek(size_t bytes) const noexcept {
+        return m_data.substr(m_offset, bytes);
+    }
+    
+    [[nodiscard]] bool atEnd() const noexcept { return m_offset == m_data.size(); }
+    
+private:
+    std::string_view m_data;
+    size_t m_offset = 0;
+};
+
+} // namespace
+
+SweepCache::SweepCache(std::filesystem::path directory, uint64_t maxBytes)
+    : m_directory(std::move(directory)), m_maxBytes(maxBytes) {}
+
+std::filesystem::path SweepCache::directory() const {
+    std::lock_guard lock(m_mutex);
+    return m_directory;
+}
+
+void SweepCache::setDirectory(std::filesystem::path directory) {
+    std::lock_guard lock(m_mutex);
+    m_directory = std::move(directory);
+}
+
+uint64_t SweepCache::maxBytes() const {
+    std::lock_guard lock(m_mutex);
+    return m_maxBytes;
+}
+
+void SweepCache::setMaxBytes(uint64_t maxBytes) {
+    std::lock_guard lock(m_mutex);
+    m_maxBytes = maxBytes;
+}
+
+std::optional<SweepCache::Key> SweepCache::keyFor(const std::filesystem::path& sourcePath) {
+    PERF_MEASURE("SweepCache::keyFor");
+    
+    std::error_code error;
+    const auto absolutePath = std::filesystem::absolute(sourcePath, error);
+    const auto modifiedTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error) {
+        return std::nullopt;
+    }
+    
+    MappedFile file;
+    if (!file.open(sourcePath, MappedFile::Access::Random)) {
+        return std::nullopt;
+    }
+    
+    Key key;
+    key.path = absolutePath.generic_string();
+    key.size = file.size();
+    key.modifiedTime = static_cast<int64_t>(modifiedTime.time_since_epoch().count());
+    key.contentHash = contentHash(file.view());
+    return key;
+}
+
+std::filesystem::path SweepCache::entryPath(const Key& key) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hashBytes(key.path, 0)));
+    return directory() / (std::string(name) + entryExtension);
+}
+
+std::optional<SweepCache::Entry> SweepCache::load(const Key& key) const {
+    PERF_MEASURE("SweepCache::load");
+    
+    const auto path = entryPath(key);
+    
+    MappedFile file;
+    if (!file.open(path, MappedFile::Access::Sequential)) {
+        return std::nullopt;
+    }
+    
+    Reader reader(file.view());
+    FileHeader header;
+    if (!reader.read(std::span(&header, 1)) ||
+        std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0 ||
+        header.version != formatVersion || header.byteOrderMark != byteOrderMark) {
+        return std::nullopt;
+    }
+    
+    // Исходный файл изменился или это другой файл с тем же хэшем пути
+    if (header.sourceSize != key.size || header.sourceModifiedTime != key.modifiedTime ||
+        header.contentHash != key.contentHash || header.pathBytes != key.path.size() ||
+        reader.peek(key.path.size()) != key.path || !reader.skip(alignTo8(header.pathBytes))) {
+        return std::nullopt;
+    }
+    
+    // Размеры проверяются до выделения памяти, чтобы битый файл не запросил лишнего
+    const size_t pointCount = header.pointCount;
+    if (pointCount > file.size() / sizeof(double) || header.levelCount > 64) {
+        return std::nullopt;
+    }
+    
+    std::vector<double> frequency(pointCount);
+    std::vector<double> real(pointCount);
+    std::vector<double> imag(pointCount);
+    std::vector<double> logMagDb(pointCount);
+    if (!reader.read(std::span(frequency)) || !reader.read(std::span(real)) ||
+        !reader.read(std::span(imag)) || !reader.read(std::span(logMagDb))) {
+        return std::nullopt;
+    }
+    
+    std::vector<uint64_t> levelSizes(header.levelCount);
+    if (!reader.read(std::span(levelSizes))) {
+        return std::nullopt;
+    }
+    
+    std::vector<std::vector<LodPyramid::Bucket>> levels(levelSizes.size());
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (levelSizes[i] > file.size() / sizeof(LodPyramid::Bucket)) {
+            return std::nullopt;
+        }
+        levels[i].resize(levelSizes[i]);
+        if (!reader.read(std::span(levels[i]))) {
+            return std::nullopt;
+        }
+    }
+    if (!reader.atEnd()) {
+        return std::nullopt;
+    }
+    
+    Entry entry;
+    entry.measurement = Measurement::fromColumns(std::move(frequency), std::move(real),
+                                                 std::move(imag), std::move(logMagDb));
+    if (!levels.empty()) {
+        entry.lod = LodPyramid::fromLevels(std::move(levels), pointCount, header.bucketSize);
+        if (!entry.lod.isValid()) {
+            return std::nullopt;
+        }
+    }
+    
+    // Время изменения файла кэша — время последнего обращения для LRU
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    
+    return entry;
+}
+
+bool SweepCache::store(const Key& key, const Measurement& measurement, const LodPyramid& lod) const {
+    const Measurement* const part = &measurement;
+    return store(key, std::span(&part, 1), lod);
+}
+
+bool SweepCache::store(const Key& key, std::span<const Measurement* const> parts, const LodPyramid& lod) const {
+    PERF_MEASURE("SweepCache::store");
+    
+    const auto path = entryPath(key);
+    
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error) {
+        return false;
+    }
+    
+    FileHeader header{};
+    std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.version = formatVersion;
+    header.byteOrderMark = byteOrderMark;
+    header.sourceSize = key.size;
+    header.sourceModifiedTime = key.modifiedTime;
+    header.contentHash = key.contentHash;
+    header.pathBytes = key.path.size();
+    header.pointCount = 0;
+    for (const Measurement* part : parts) {
+        header.pointCount += part->size();
+    }
+    header.bucketSize = lod.bucketSize();
+    header.levelCount = lod.levelCount();
+    
+    std::vector<uint64_t> levelSizes(lod.levelCount());
+    for (size_t i = 0; i < levelSizes.size(); ++i) {
+        levelSizes[i] = lod.level(i).size();
+    }
+    
+    // Пишем во временный файл и подменяем целиком: читатель видит либо старую запись, либо новую
+    auto temporaryPath = path;
+    temporaryPath += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        
+        const char padding[8] = {};
+        writeSpan(out, std::span<const FileHeader>(&header, 1));
+        out.write(key.path.data(), static_cast<std::streamsize>(key.path.size()));
+        out.write(padding, static_cast<std::streamsize>(alignTo8(key.path.size()) - key.path.size()));
+        
+        // Каждый столбец лежит в файле целиком, куски пишутся друг за другом
+        for (const Measurement* part : parts) {
+            writeSpan(out, part->frequencies());
+        }
+        for (const Measurement* part : parts) {
+            writeSpan(out, part->realParts());
+        }
+        for (const Measurement* part : parts) {
+            writeSpan(out, part->imagParts());
+        }
+        for (const Measurement* part : parts) {
+            writeSpan(out, part->logMagnitudes());
+        }
+        
+        writeSpan(out, std::span<const uint64_t>(levelSizes));
+        for (size_t i = 0; i < levelSizes.size(); ++i) {
+            writeSpan(out, lod.level(i));
+        }
+        
+        if (!out.flush()) {
+            out.close();
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+    
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    
+    evict();
+    return true;
+}
+
+void SweepCache::evict() const {
+    struct CachedFile {
+        std::filesystem::path path;
+        uint64_t size;
+        std::filesystem::file_time_type lastUsed;
+    };
+    
+    const auto cacheDirectory = directory();
+    const uint64_t limit = maxBytes();
+    
+    std::error_code error;
+    std::vector<CachedFile> files;
+    uint64_t totalBytes = 0;
+    for (const auto& item : std::filesystem::directory_iterator(cacheDirectory, error)) {
+        if (item.path().extension() != entryExtension || !item.is_regular_file(error)) {
+            continue;
+        }
+        
+        CachedFile file{item.path(), item.file_size(error), item.last_write_time(error)};
+        if (!error) {
+            totalBytes += file.size;
+            files.push_back(std::move(file));
+        }
+    }
+    
+    std::sort(files.begin(), files.end(), [](const CachedFile& a, const CachedFile& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    
+    // Открытый другим потоком файл может не удалиться (Windows) — тогда просто пропускаем
+    for (const auto& file : files) {
+        if (totalBytes <= limit) {
+            break;
+        }
+        if (std::filesystem::remove(file.path, error)) {
+            totalBytes -= file.size;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Measurement.h"
+#include "LodPyramid.h"
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+
+// Бинарный кэш разобранных .s1p в отдельном каталоге: столбцы частоты, Re, Im,
+// |S11| дБ и уровни LOD-пирамиды в одном файле фиксированного формата.
+// Файл кэша привязан к исходному по пути, размеру, времени изменения и хэшу
+// содержимого; при совпадении загрузка сводится к отображению файла в память
+// и копированию готовых столбцов. Каталог ограничен по размеру, лишние файлы
+// удаляются начиная с давно не открывавшихся (LRU).
+// Методы можно вызывать из рабочих потоков; запись идет через временный файл.
+class SweepCache {
+public:
+    // Версия формата; файлы другой версии считаются промахом
+    static constexpr uint32_t formatVersion = 1;
+    static constexpr uint64_t defaultMaxBytes = 2ull * 1024 * 1024 * 1024;
+    
+    struct Key {
+        std::string path;
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+        uint64_t contentHash = 0;
+    };
+    
+    struct Entry {
+        Measurement measurement;
+        LodPyramid lod;
+    };
+    
+    explicit SweepCache(std::filesystem::path directory, uint64_t maxBytes = defaultMaxBytes);
+    
+    [[nodiscard]] std::filesystem::path directory() const;
+    void setDirectory(std::filesystem::path directory);
+    [[nodiscard]] uint64_t maxBytes() const;
+    void setMaxBytes(uint64_t maxBytes);
+    
+    // Ключ текущего состояния исходного файла; nullopt, если файл недоступен
+    [[nodiscard]] static std::optional<Key> keyFor(const std::filesystem::path& sourcePath);
+    
+    [[nodiscard]] std::optional<Entry> load(const Key& key) const;
+    bool store(const Key& key, const Measurement& measurement, const LodPyramid& lod) const;
+    // То же для точек, разложенных по нескольким кускам подряд; lod — пирамида по всем точкам
+    bool store(const Key& key, std::span<const Measurement* const> parts, const LodPyramid& lod) const;
+    
+    // Удаление самых старых файлов, пока каталог не уложится в maxBytes
+    void evict() const;
+    
+private:
+    [[nodiscard]] std::filesystem::path entryPath(const Key& key) const;
+    
+    mutable std::mutex m_mutex;
+    std::filesystem::path m_directory;
+    uint64_t m_maxBytes;
+};
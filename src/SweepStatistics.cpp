@@ -0,0 +1,172 @@
+#include "SweepStatistics.h"
+#include "PerformanceUtils.h"
+#include "Resampler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+uint64_t nextEnvelopeVersion() noexcept {
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // namespace
+
+std::pair<size_t, size_t> SweepStatistics::Envelope::visibleRange(double freqMin, double freqMax) const {
+    const auto first = std::lower_bound(frequency.begin(), frequency.end(), freqMin);
+    const auto last = std::upper_bound(first, frequency.end(), freqMax);
+    const size_t begin = static_cast<size_t>(first - frequency.begin());
+    const size_t end = static_cast<size_t>(last - frequency.begin());
+    return {begin > 0 ? begin - 1 : 0, std::min(end + 1, frequency.size())};
+}
+
+std::pair<double, double> SweepStatistics::Envelope::range(double freqMin, double freqMax) const {
+    double low = std::numeric_limits<double>::infinity();
+    double high = -std::numeric_limits<double>::infinity();
+    
+    const auto first = std::lower_bound(frequency.begin(), frequency.end(), freqMin);
+    const auto last = std::upper_bound(first, frequency.end(), freqMax);
+    for (size_t i = static_cast<size_t>(first - frequency.begin()); i < static_cast<size_t>(last - frequency.begin()); ++i) {
+        low = std::min(low, min[i]);
+        high = std::max(high, max[i]);
+    }
+    return {low, high};
+}
+
+SweepStatistics::SweepStatistics(size_t maxGridPoints)
+    : m_maxGridPoints(std::max<size_t>(2, maxGridPoints)) {}
+
+SweepStatistics::SweepStatistics(std::vector<double> grid) {
+    setGrid(std::move(grid));
+}
+
+std::vector<double> SweepStatistics::uniformGrid(double minFrequency, double maxFrequency, size_t points) {
+    std::vector<double> grid(points);
+    if (points == 1) {
+        grid[0] = minFrequency;
+    }
+    if (points < 2) {
+        return grid;
+    }
+    
+    const double step = (maxFrequency - minFrequency) / static_cast<double>(points - 1);
+    for (size_t i = 0; i < points; ++i) {
+        grid[i] = minFrequency + static_cast<double>(i) * step;
+    }
+    // Последняя точка ровно на краю, без накопленной погрешности шага
+    grid.back() = maxFrequency;
+    return grid;
+}
+
+void SweepStatistics::setGrid(std::vector<double> grid) {
+    m_grid = std::move(grid);
+    const size_t size = m_grid.size();
+    m_count.assign(size, 0);
+    m_mean.assign(size, 0.0);
+    m_m2.assign(size, 0.0);
+    m_min.assign(size, std::numeric_limits<double>::infinity());
+    m_max.assign(size, -std::numeric_limits<double>::infinity());
+}
+
+size_t SweepStatistics::memoryBytes() const noexcept {
+    return m_grid.capacity() * sizeof(double) + m_count.capacity() * sizeof(uint32_t) +
+           (m_mean.capacity() + m_m2.capacity() + m_min.capacity() + m_max.capacity() + m_resampled.capacity()) *
+               sizeof(double);
+}
+
+bool SweepStatistics::add(const Measurement& measurement) {
+    if (!measurement.isSortedByFrequency()) {
+        return false;
+    }
+    return add(measurement.frequencies(), measurement.logMagnitudes());
+}
+
+bool SweepStatistics::add(std::span<const double> frequency, std::span<const double> magnitudeDb) {
+    PERF_MEASURE("SweepStatistics::add");
+    
+    if (frequency.empty() || frequency.size() != magnitudeDb.size()) {
+        return false;
+    }
+    
+    // Первый свип задает сетку
+    if (m_grid.empty()) {
+        if (frequency.size() <= m_maxGridPoints) {
+            setGrid(std::vector<double>(frequency.begin(), frequency.end()));
+        } else {
+            setGrid(uniformGrid(frequency.front(), frequency.back(), m_maxGridPoints));
+        }
+    }
+    
+    // Та же сетка — значения сворачиваются без интерполяции
+    if (frequency.size() == m_grid.size() && std::equal(frequency.begin(), frequency.end(), m_grid.begin())) {
+        fold(0, m_grid.size(), magnitudeDb.data());
+        ++m_sweepCount;
+        return true;
+    }
+    
+    // Точки сетки внутри диапазона свипа; вне его свип ничего не добавляет
+    const auto [begin, end] = Resampler::coveredRange(frequency, m_grid);
+    if (begin >= end) {
+        return false;
+    }
+    
+    m_resampled.resize(m_grid.size());
+    const std::span<const double> covered(m_grid.data() + begin, end - begin);
+    Resampler::resample(frequency, magnitudeDb, covered, std::span<double>(m_resampled.data() + begin, end - begin),
+                        Resampler::Options{});
+    
+    fold(begin, end, m_resampled.data());
+    ++m_sweepCount;
+    return true;
+}
+
+void SweepStatistics::fold(size_t begin, size_t end, const double* values) {
+    // Без зависимостей между точками: цикл векторизуется
+    for (size_t i = begin; i < end; ++i) {
+        const double x = values[i];
+        const uint32_t count = ++m_count[i];
+        const double delta = x - m_mean[i];
+        m_mean[i] += delta / static_cast<double>(count);
+        m_m2[i] += delta * (x - m_mean[i]);
+        m_min[i] = std::min(m_min[i], x);
+        m_max[i] = std::max(m_max[i], x);
+    }
+}
+
+SweepStatistics::EnvelopePtr SweepStatistics::envelope() const {
+    PERF_MEASURE("SweepStatistics::envelope");
+    
+    auto envelope = std::make_shared<Envelope>();
+    envelope->sweepCount = m_sweepCount;
+    envelope->version = nextEnvelopeVersion();
+    
+    const size_t covered = static_cast<size_t>(std::count_if(m_count.begin(), m_count.end(),
+                                                             [](uint32_t count) { return count > 0; }));
+    envelope->frequency.reserve(covered);
+    envelope->mean.reserve(covered);
+    envelope->stdDev.reserve(covered);
+    envelope->min.reserve(covered);
+    envelope->max.reserve(covered);
+    
+    for (size_t i = 0; i < m_grid.size(); ++i) {
+        if (m_count[i] == 0) {
+            continue;
+        }
+        // Выборочное СКО; у единственного свипа разброса нет
+        const double variance = m_count[i] > 1 ? m_m2[i] / static_cast<double>(m_count[i] - 1) : 0.0;
+        envelope->frequency.push_back(m_grid[i]);
+        envelope->mean.push_back(m_mean[i]);
+        envelope->stdDev.push_back(std::sqrt(std::max(variance, 0.0)));
+        envelope->min.push_back(m_min[i]);
+        envelope->max.push_back(m_max[i]);
+    }
+    
+    if (!envelope->empty()) {
+        envelope->minValue = *std::min_element(envelope->min.begin(), envelope->min.end());
+        envelope->maxValue = *std::max_element(envelope->max.begin(), envelope->max.end());
+    }
+    return envelope;
+}
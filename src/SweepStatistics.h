@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Measurement.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Статистика |S11| дБ по многим свипам одной детали: среднее, СКО, минимум
+// и максимум на каждой частоте общей сетки. Свипы сворачиваются по одному
+// (алгоритм Уэлфорда) и после add() не нужны, поэтому память — O(размер сетки)
+// при любом числе свипов. Свип на другой сетке интерполируется на общую
+// линейно в дБ; точки сетки вне диапазона свипа он не затрагивает.
+// Не потокобезопасен: свертку из нескольких потоков вызывающий сериализует сам.
+class SweepStatistics {
+public:
+    // Больше точек в сетке не нужно для отображения; длинный первый свип
+    // заменяется равномерной сеткой на его диапазоне
+    static constexpr size_t defaultMaxGridPoints = 1u << 20;
+    
+    // Готовые к отрисовке столбцы: только точки сетки, покрытые хотя бы одним свипом
+    struct Envelope {
+        std::vector<double> frequency;
+        std::vector<double> mean;
+        std::vector<double> stdDev;
+        std::vector<double> min;
+        std::vector<double> max;
+        // Крайние значения по всей огибающей
+        double minValue = 0.0;
+        double maxValue = 0.0;
+        size_t sweepCount = 0;
+        // Уникальный номер, ключ для кэшей отрисовки
+        uint64_t version = 0;
+        
+        [[nodiscard]] size_t size() const noexcept { return frequency.size(); }
+        [[nodiscard]] bool empty() const noexcept { return frequency.empty(); }
+        // Индексы точек с частотой в [freqMin, freqMax] и по соседу с краев
+        [[nodiscard]] std::pair<size_t, size_t> visibleRange(double freqMin, double freqMax) const;
+        // Минимум min и максимум max в окне частот; {+inf, -inf}, если точек нет
+        [[nodiscard]] std::pair<double, double> range(double freqMin, double freqMax) const;
+    };
+    using EnvelopePtr = std::shared_ptr<const Envelope>;
+    
+    // Сетка берется с первого свипа
+    explicit SweepStatistics(size_t maxGridPoints = defaultMaxGridPoints);
+    // Заданная заранее сетка (по возрастанию)
+    explicit SweepStatistics(std::vector<double> grid);
+    
+    // false — свип пуст, не отсортирован по частоте или не пересекается с сеткой
+    bool add(const Measurement& measurement);
+    bool add(std::span<const double> frequency, std::span<const double> magnitudeDb);
+    
+    [[nodiscard]] size_t sweepCount() const noexcept { return m_sweepCount; }
+    [[nodiscard]] const std::vector<double>& grid() const noexcept { return m_grid; }
+    // Память под сетку и накопители
+    [[nodiscard]] size_t memoryBytes() const noexcept;
+    
+    [[nodiscard]] EnvelopePtr envelope() const;
+    
+    // Равномерная сетка из points точек на [minFrequency, maxFrequency]
+    [[nodiscard]] static std::vector<double> uniformGrid(double minFrequency, double maxFrequency, size_t points);
+    
+private:
+    void setGrid(std::vector<double> grid);
+    void fold(size_t begin, size_t end, const double* values);
+    
+    std::vector<double> m_grid;
+    // Накопители Уэлфорда по точкам сетки
+    std::vector<uint32_t> m_count;
+    std::vector<double> m_mean;
+    std::vector<double> m_m2;
+    std::vector<double> m_min;
+    std::vector<double> m_max;
+    // Значения очередного свипа на сетке; переиспользуется между вызовами add()
+    std::vector<double> m_resampled;
+    size_t m_maxGridPoints = defaultMaxGridPoints;
+    size_t m_sweepCount = 0;
+};
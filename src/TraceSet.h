@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <QtGlobal>
+#include "MeasurementSnapshot.h"
+#include "SweepStatistics.h"
+#include "GraphRenderer.h"
+
+// Неизменяемый набор трасс, наложенных на основной снимок (сравнение
+// нескольких файлов). Каждая трасса — отдельный MeasurementSnapshot со своей
+// LOD-пирамидой, поэтому кадр стоит порядка пиксели x трассы, а не числа точек.
+// Как и снимок, набор публикуется как shared_ptr<const> и заменяется целиком.
+class TraceSet {
+public:
+    using Ptr = std::shared_ptr<const TraceSet>;
+    
+    struct Trace {
+        MeasurementSnapshot::Ptr snapshot;
+        // Номер файла в выборке (0 — основной снимок): цвет не зависит от порядка загрузки
+        size_t colorIndex = 0;
+    };
+    
+    TraceSet() = default;
+    
+    // Трассы упорядочиваются по colorIndex, пустые снимки отбрасываются
+    [[nodiscard]] static Ptr create(std::vector<Trace> traces) {
+        std::erase_if(traces, [](const Trace& trace) { return !trace.snapshot || trace.snapshot->empty(); });
+        std::sort(traces.begin(), traces.end(), [](const Trace& a, const Trace& b) {
+            return a.colorIndex < b.colorIndex;
+        });
+        
+        auto set = std::make_shared<TraceSet>();
+        for (const Trace& trace : traces) {
+            set->m_dataBounds = set->m_traces.empty() ? trace.snapshot->dataBounds()
+                                                      : unite(set->m_dataBounds, trace.snapshot->dataBounds());
+            set->m_traces.push_back(trace);
+        }
+        set->m_version = nextVersion();
+        return set;
+    }
+    
+    [[nodiscard]] const std::vector<Trace>& traces() const noexcept { return m_traces; }
+    // Объединение границ всех трасс набора
+    [[nodiscard]] const GraphRenderer::GraphBounds& dataBounds() const noexcept { return m_dataBounds; }
+    // Уникальный номер набора, ключ для кэша слоя трасс
+    [[nodiscard]] quint64 version() const noexcept { return m_version; }
+    [[nodiscard]] size_t size() const noexcept { return m_traces.size(); }
+    [[nodiscard]] bool empty() const noexcept { return m_traces.empty(); }
+    
+    [[nodiscard]] size_t residentPoints() const noexcept {
+        size_t points = 0;
+        for (const Trace& trace : m_traces) {
+            points += trace.snapshot->residentPoints();
+        }
+        return points;
+    }
+    
+    [[nodiscard]] size_t residentBytes() const {
+        size_t bytes = 0;
+        for (const Trace& trace : m_traces) {
+            bytes += trace.snapshot->residentBytes();
+        }
+        return bytes;
+    }
+    
+    [[nodiscard]] static GraphRenderer::GraphBounds unite(const GraphRenderer::GraphBounds& a,
+                                                          const GraphRenderer::GraphBounds& b) noexcept {
+        return {std::min(a.minFreq, b.minFreq), std::max(a.maxFreq, b.maxFreq),
+                std::min(a.minMag, b.minMag), std::max(a.maxMag, b.maxMag)};
+    }
+    
+    // Границы всего, что на графике: основной снимок, наложенные трассы
+    // и огибающая статистики (любого из них может не быть)
+    [[nodiscard]] static GraphRenderer::GraphBounds combinedBounds(const MeasurementSnapshot::Ptr& primary,
+                                                                   const Ptr& overlays,
+                                                                   const SweepStatistics::EnvelopePtr& envelope = nullptr) {
+        GraphRenderer::GraphBounds bounds{};
+        bool found = false;
+        const auto include = [&](const GraphRenderer::GraphBounds& other) {
+            bounds = found ? unite(bounds, other) : other;
+            found = true;
+        };
+        
+        if (primary && !primary->empty()) {
+            include(primary->dataBounds());
+        }
+        if (overlays && !overlays->empty()) {
+            include(overlays->dataBounds());
+        }
+        if (envelope && !envelope->empty()) {
+            include(GraphRenderer::calculateBounds(*envelope));
+        }
+        return bounds;
+    }
+    
+private:
+    static quint64 nextVersion() noexcept {
+        static std::atomic<quint64> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    
+    std::vector<Trace> m_traces;
+    GraphRenderer::GraphBounds m_dataBounds{};
+    quint64 m_version = 0;
+};
@@ -5,6 +5,7 @@
 #include <qDebug>
 #include "Backend.h"
 #include "GraphWidget.h"
+#include "PerformanceUtils.h"
 
 int main(int argc, char *argv[])
 {
@@ -27,5 +28,10 @@ int main(int argc, char *argv[])
         qFatal("Failed to load QML file");
     }
 
-    return app.exec();
+    const int exitCode = app.exec();
+    
+    // Только в сборке с TOUCHSTONE_ENABLE_TRACING
+    PERF_WRITE_TRACE(qEnvironmentVariable("TOUCHSTONE_TRACE_FILE", "touchstone-trace.json").toStdString());
+    
+    return exitCode;
 }
@@ -0,0 +1,70 @@
+#pragma once
+
+// Общее для пакетных утилит: сбор .s1p по аргументам командной строки
+// и текст статуса разбора.
+
+#include "S11Parser.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class BatchFiles {
+public:
+    struct InputFile {
+        std::filesystem::path path;
+        // Путь относительно каталога из аргументов (для файла из аргументов — имя файла)
+        std::filesystem::path relativePath;
+        
+        friend bool operator==(const InputFile& a, const InputFile& b) { return a.path == b.path; }
+        friend bool operator<(const InputFile& a, const InputFile& b) { return a.path < b.path; }
+    };
+    
+    // Файлы из аргументов как есть, из каталогов — все .s1p рекурсивно; по пути, без повторов
+    [[nodiscard]] static std::vector<InputFile> collect(const std::vector<std::filesystem::path>& inputs) {
+        std::vector<InputFile> files;
+        for (const auto& input : inputs) {
+            std::error_code error;
+            if (!std::filesystem::is_directory(input, error)) {
+                files.push_back({input, input.filename()});
+                continue;
+            }
+            
+            const auto options = std::filesystem::directory_options::skip_permission_denied;
+            for (std::filesystem::recursive_directory_iterator it(input, options, error), end; it != end;
+                 it.increment(error)) {
+                if (it->is_regular_file(error) && hasTouchstoneExtension(it->path())) {
+                    files.push_back({it->path(), it->path().lexically_relative(input)});
+                }
+            }
+            if (error) {
+                std::fprintf(stderr, "warning: %s: %s\n", input.string().c_str(), error.message().c_str());
+            }
+        }
+        
+        std::sort(files.begin(), files.end());
+        files.erase(std::unique(files.begin(), files.end()), files.end());
+        return files;
+    }
+    
+    [[nodiscard]] static bool hasTouchstoneExtension(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension == ".s1p";
+    }
+    
+    [[nodiscard]] static const char* statusText(S11Parser::ParseResult result) noexcept {
+        switch (result) {
+            case S11Parser::ParseResult::Success: return "ok";
+            case S11Parser::ParseResult::FileNotFound: return "file not found";
+            case S11Parser::ParseResult::InvalidFormat: return "invalid format";
+            case S11Parser::ParseResult::EmptyFile: return "no data points";
+            case S11Parser::ParseResult::Cancelled: return "cancelled";
+            case S11Parser::ParseResult::UnsortedFrequencies: return "unsorted frequencies";
+        }
+        return "";
+    }
+};
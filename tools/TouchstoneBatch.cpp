@@ -0,0 +1,316 @@
+// Пакетный анализ .s1p без GUI: каталоги обходятся рекурсивно, файлы
+// разбираются параллельно (по файлу на поток), по каждому файлу выводятся
+// число точек, минимум |S11| и его частота и полоса по уровню (-10 дБ).
+// С --mask каждый файл проверяется по маске допуска (LimitMask): годен/брак,
+// худший запас и его частота, число точек и участков за границей.
+//
+// TouchstoneBatch [--format csv|json] [--output FILE] [--jobs N] [--level DB] [--mask FILE] PATH...
+//
+// Код возврата: 0 — все файлы разобраны (и годны по маске), 3 — часть файлов с ошибками,
+// 4 — все разобраны, но часть не прошла маску, 1 и 2 — ошибки вывода и аргументов.
+
+#include "BatchFiles.h"
+#include "LimitMask.h"
+#include "S11Parser.h"
+#include "SweepAnalysis.h"
+#include "PerformanceUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace {
+
+enum class OutputFormat {
+    Csv,
+    Json
+};
+
+struct Options {
+    std::vector<std::filesystem::path> inputs;
+    OutputFormat format = OutputFormat::Csv;
+    std::filesystem::path outputPath;
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    double bandLevelDb = SweepAnalysis::defaultBandLevelDb;
+    std::filesystem::path maskPath;
+    std::optional<LimitMask> mask;
+};
+
+struct FileResult {
+    std::filesystem::path path;
+    S11Parser::ParseResult status = S11Parser::ParseResult::FileNotFound;
+    size_t bytes = 0;
+    SweepAnalysis::Metrics metrics;
+    // Только с --mask и для разобранных файлов
+    std::optional<LimitMask::Result> mask;
+};
+
+// Потоки берут файлы по одному из общего счетчика: крупные файлы не тормозят остальных.
+// Когда файлов меньше потоков, каждый файл разбирается еще и параллельно по блокам
+void analyzeAll(const std::vector<BatchFiles::InputFile>& files, const Options& options,
+                std::vector<FileResult>& results) {
+    PERF_MEASURE("TouchstoneBatch::analyzeAll");
+    
+    results.assign(files.size(), {});
+    
+    S11Parser::ParseOptions parseOptions;
+    if (files.size() >= options.jobs) {
+        parseOptions.parallelThreshold = std::numeric_limits<size_t>::max();
+    }
+    
+    std::atomic<size_t> next{0};
+    const auto worker = [&]() {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < files.size();
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+            FileResult& result = results[i];
+            result.path = files[i].path;
+            
+            S11Parser::ParseStats stats;
+            auto parsed = S11Parser::parseFileExpected(files[i].path, &stats, parseOptions);
+            result.bytes = stats.bytesRead;
+            if (const auto* measurement = std::get_if<Measurement>(&parsed)) {
+                result.status = S11Parser::ParseResult::Success;
+                result.metrics = SweepAnalysis::analyze(*measurement, options.bandLevelDb);
+                if (options.mask) {
+                    result.mask = options.mask->evaluate(*measurement);
+                }
+            } else {
+                result.status = std::get<S11Parser::ParseResult>(parsed);
+            }
+        }
+    };
+    
+    std::vector<std::jthread> threads;
+    const size_t threadCount = std::min(options.jobs, files.size());
+    threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+}
+
+std::string csvField(const std::string& text) {
+    if (text.find_first_of(",\"\r\n") == std::string::npos) {
+        return text;
+    }
+    std::string quoted = "\"";
+    for (char c : text) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+std::string jsonString(const std::string& text) {
+    std::string escaped = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped + "\"";
+}
+
+// Частоты — с точностью до герца на любых диапазонах, дБ — до 0.0001
+std::string formatNumber(double value, const char* format, const char* missing) {
+    if (!std::isfinite(value)) {
+        return missing;
+    }
+    char text[64];
+    std::snprintf(text, sizeof(text), format, value);
+    return text;
+}
+
+// Колонки маски добавляются только с --mask, без нее формат прежний
+void writeCsv(std::FILE* file, const std::vector<FileResult>& results, bool withMask) {
+    std::fputs("path,status,points,min_s11_db,min_s11_freq_hz,band_low_hz,band_high_hz,band_hz,band_clipped", file);
+    std::fputs(withMask ? ",mask_pass,mask_margin_db,mask_worst_freq_hz,mask_failed_points,mask_violations\n" : "\n", file);
+    for (const FileResult& result : results) {
+        const auto& metrics = result.metrics;
+        const auto& band = metrics.band;
+        std::fprintf(file, "%s,%s,%zu,%s,%s,%s,%s,%s,%s",
+                     csvField(result.path.string()).c_str(), BatchFiles::statusText(result.status), metrics.pointCount,
+                     formatNumber(metrics.minS11Db, "%.4f", "").c_str(),
+                     formatNumber(metrics.minS11Frequency, "%.0f", "").c_str(),
+                     band ? formatNumber(band->lowFrequency, "%.0f", "").c_str() : "",
+                     band ? formatNumber(band->highFrequency, "%.0f", "").c_str() : "",
+                     band ? formatNumber(band->width(), "%.0f", "").c_str() : "",
+                     band ? (band->clippedLow || band->clippedHigh ? "1" : "0") : "");
+        if (!withMask) {
+            std::fputc('\n', file);
+        } else if (const auto& mask = result.mask) {
+            std::fprintf(file, ",%s,%s,%s,%zu,%zu\n", mask->passed() ? "1" : "0",
+                         formatNumber(mask->worstMarginDb, "%.4f", "").c_str(),
+                         formatNumber(mask->worstFrequency, "%.0f", "").c_str(),
+                         mask->failedPoints, mask->violations.size());
+        } else {
+            std::fputs(",,,,,\n", file);
+        }
+    }
+}
+
+void writeJson(std::FILE* file, const std::vector<FileResult>& results, const Options& options) {
+    std::fprintf(file, "{\n  \"bandLevelDb\": %s,\n", formatNumber(options.bandLevelDb, "%g", "null").c_str());
+    if (options.mask) {
+        std::fprintf(file, "  \"mask\": %s,\n", jsonString(options.maskPath.string()).c_str());
+    }
+    std::fputs("  \"files\": [", file);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const FileResult& result = results[i];
+        const auto& metrics = result.metrics;
+        std::fprintf(file, "%s\n    {\"path\": %s, \"status\": \"%s\", \"points\": %zu, "
+                           "\"minS11Db\": %s, \"minS11FrequencyHz\": %s, \"band\": ",
+                     i ? "," : "", jsonString(result.path.string()).c_str(), BatchFiles::statusText(result.status),
+                     metrics.pointCount, formatNumber(metrics.minS11Db, "%.4f", "null").c_str(),
+                     formatNumber(metrics.minS11Frequency, "%.0f", "null").c_str());
+        if (const auto& band = metrics.band) {
+            std::fprintf(file, "{\"lowHz\": %.0f, \"highHz\": %.0f, \"widthHz\": %.0f, "
+                               "\"clippedLow\": %s, \"clippedHigh\": %s}",
+                         band->lowFrequency, band->highFrequency, band->width(),
+                         band->clippedLow ? "true" : "false", band->clippedHigh ? "true" : "false");
+        } else {
+            std::fputs("null", file);
+        }
+        if (const auto& mask = result.mask) {
+            std::fprintf(file, ", \"mask\": {\"pass\": %s, \"complete\": %s, \"marginDb\": %s, "
+                               "\"worstFrequencyHz\": %s, \"checkedPoints\": %zu, \"failedPoints\": %zu, "
+                               "\"violations\": [",
+                         mask->passed() ? "true" : "false", mask->complete ? "true" : "false",
+                         formatNumber(mask->worstMarginDb, "%.4f", "null").c_str(),
+                         formatNumber(mask->worstFrequency, "%.0f", "null").c_str(),
+                         mask->checkedPoints, mask->failedPoints);
+            for (size_t v = 0; v < mask->violations.size(); ++v) {
+                const auto& violation = mask->violations[v];
+                std::fprintf(file, "%s{\"segment\": %zu, \"lowHz\": %.0f, \"highHz\": %.0f, \"points\": %zu, "
+                                   "\"marginDb\": %.4f, \"worstFrequencyHz\": %.0f}",
+                             v ? ", " : "", violation.segment, violation.lowFrequency, violation.highFrequency,
+                             violation.pointCount, violation.worstMarginDb, violation.worstFrequency);
+            }
+            std::fputs("]}", file);
+        }
+        std::fputc('}', file);
+    }
+    std::fputs("\n  ]\n}\n", file);
+}
+
+bool parseArguments(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (!arg.starts_with("--")) {
+            options.inputs.emplace_back(argv[i]);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string_view value = argv[++i];
+        
+        if (arg == "--format") {
+            if (value == "csv") {
+                options.format = OutputFormat::Csv;
+            } else if (value == "json") {
+                options.format = OutputFormat::Json;
+            } else {
+                return false;
+            }
+        } else if (arg == "--output") {
+            options.outputPath = value;
+        } else if (arg == "--jobs") {
+            options.jobs = std::max<size_t>(1, std::strtoull(value.data(), nullptr, 10));
+        } else if (arg == "--level") {
+            options.bandLevelDb = std::strtod(value.data(), nullptr);
+        } else if (arg == "--mask") {
+            options.maskPath = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.inputs.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--format csv|json] [--output FILE] [--jobs N] [--level DB] [--mask FILE] PATH...\n",
+                     argv[0]);
+        return 2;
+    }
+    
+    if (!options.maskPath.empty()) {
+        auto loaded = LimitMask::load(options.maskPath);
+        if (const auto* error = std::get_if<LimitMask::LoadError>(&loaded)) {
+            std::fprintf(stderr, "%s:%zu: %s\n", options.maskPath.string().c_str(), error->line, error->message.c_str());
+            return 2;
+        }
+        options.mask = std::move(std::get<LimitMask>(loaded));
+    }
+    
+    const auto start = std::chrono::steady_clock::now();
+    const auto files = BatchFiles::collect(options.inputs);
+    
+    std::vector<FileResult> results;
+    analyzeAll(files, options, results);
+    
+    std::FILE* output = options.outputPath.empty() ? stdout : std::fopen(options.outputPath.string().c_str(), "wb");
+    if (!output) {
+        std::fprintf(stderr, "cannot write %s\n", options.outputPath.string().c_str());
+        return 1;
+    }
+    if (options.format == OutputFormat::Csv) {
+        writeCsv(output, results, options.mask.has_value());
+    } else {
+        writeJson(output, results, options);
+    }
+    const bool written = output == stdout ? std::fflush(stdout) == 0 : std::fclose(output) == 0;
+    
+    // Сводка в stderr, чтобы не мешать выводу в stdout
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t failed = 0;
+    size_t rejected = 0;
+    size_t bytes = 0;
+    for (const FileResult& result : results) {
+        failed += result.status != S11Parser::ParseResult::Success;
+        rejected += result.mask && !result.mask->passed();
+        bytes += result.bytes;
+    }
+    std::fprintf(stderr, "%zu files (%zu failed), %.1f MB in %.2f s, %.1f files/s, %.1f MB/s, %zu jobs\n",
+                 results.size(), failed, static_cast<double>(bytes) / (1024.0 * 1024.0), seconds,
+                 static_cast<double>(results.size()) / seconds, static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds,
+                 options.jobs);
+    if (options.mask) {
+        std::fprintf(stderr, "mask %s: %zu passed, %zu rejected\n", options.maskPath.string().c_str(),
+                     results.size() - failed - rejected, rejected);
+    }
+    
+    // Только в сборке с TOUCHSTONE_ENABLE_TRACING
+    PERF_WRITE_TRACE(std::getenv("TOUCHSTONE_TRACE_FILE") ? std::getenv("TOUCHSTONE_TRACE_FILE")
+                                                          : "touchstone-batch-trace.json");
+    
+    if (!written) {
+        return 1;
+    }
+    if (failed != 0) {
+        return 3;
+    }
+    return rejected == 0 ? 0 : 4;
+}
@@ -0,0 +1,169 @@
+// Пакетная отрисовка .s1p в PNG без окна: для каждого файла строится та же
+// LOD-пирамида, что и в GUI, и кадр рисуется PlotPainter::renderFrame в QImage
+// (сетка, оси, подписи, трасса). Файлы обрабатываются параллельно, по файлу на поток.
+// Структура каталогов из аргументов повторяется в выходном каталоге.
+//
+// TouchstoneRender [--output DIR] [--size WxH] [--dpr X] [--jobs N] [--png-quality Q] PATH...
+//
+// Код возврата: 0 — все картинки записаны, 3 — часть файлов с ошибками, 2 — ошибка аргументов.
+
+#include "BatchFiles.h"
+#include "S11Parser.h"
+#include "LodPyramid.h"
+#include "GraphRenderer.h"
+#include "PlotPainter.h"
+#include "PerformanceUtils.h"
+#include <QGuiApplication>
+#include <QImage>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<std::filesystem::path> inputs;
+    std::filesystem::path outputDirectory = ".";
+    QSize size{800, 450};
+    qreal devicePixelRatio = 1.0;
+    int jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    // -1 — уровень сжатия PNG по умолчанию; меньше — сильнее сжатие и медленнее
+    int pngQuality = -1;
+};
+
+struct RenderJob {
+    BatchFiles::InputFile input;
+    std::filesystem::path outputPath;
+    S11Parser::ParseResult status = S11Parser::ParseResult::FileNotFound;
+    bool saved = false;
+};
+
+// Как у GraphWidget без зума: границы по корню пирамиды, трасса по ее уровням
+void renderOne(RenderJob& job, const Options& options, const S11Parser::ParseOptions& parseOptions) {
+    PERF_MEASURE("TouchstoneRender::renderOne");
+    
+    auto parsed = S11Parser::parseFileExpected(job.input.path, nullptr, parseOptions);
+    auto* measurement = std::get_if<Measurement>(&parsed);
+    if (!measurement) {
+        job.status = std::get<S11Parser::ParseResult>(parsed);
+        return;
+    }
+    job.status = S11Parser::ParseResult::Success;
+    
+    const auto lod = LodPyramid::build(measurement->frequencies(), measurement->logMagnitudes());
+    const auto bounds = GraphRenderer::calculateBounds(*measurement, lod);
+    const QImage frame = PlotPainter::renderFrame(*measurement, lod, bounds, false, options.size,
+                                                  options.devicePixelRatio);
+    
+    // Фон непрозрачный: без альфа-канала PNG меньше и кодируется быстрее
+    std::error_code error;
+    std::filesystem::create_directories(job.outputPath.parent_path(), error);
+    job.saved = frame.convertToFormat(QImage::Format_RGB32)
+                    .save(QString::fromStdString(job.outputPath.string()), "PNG", options.pngQuality);
+}
+
+bool parseArguments(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (!arg.starts_with("--")) {
+            options.inputs.emplace_back(argv[i]);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        
+        if (arg == "--output") {
+            options.outputDirectory = value;
+        } else if (arg == "--size") {
+            int width = 0;
+            int height = 0;
+            if (std::sscanf(value, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                return false;
+            }
+            options.size = QSize(width, height);
+        } else if (arg == "--dpr") {
+            options.devicePixelRatio = std::max(0.1, std::strtod(value, nullptr));
+        } else if (arg == "--jobs") {
+            options.jobs = std::max(1, std::atoi(value));
+        } else if (arg == "--png-quality") {
+            options.pngQuality = std::clamp(std::atoi(value), -1, 100);
+        } else {
+            return false;
+        }
+    }
+    return !options.inputs.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--output DIR] [--size WxH] [--dpr X] [--jobs N] [--png-quality Q] PATH...\n",
+                     argv[0]);
+        return 2;
+    }
+    
+    // Шрифтам подписей нужен QGuiApplication; окна не создаются
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    
+    const auto start = std::chrono::steady_clock::now();
+    
+    std::vector<RenderJob> jobs;
+    for (auto& input : BatchFiles::collect(options.inputs)) {
+        RenderJob job;
+        job.outputPath = (options.outputDirectory / input.relativePath).replace_extension(".png");
+        job.input = std::move(input);
+        jobs.push_back(std::move(job));
+    }
+    
+    // Файлов больше, чем потоков, — каждый разбирается одним блоком в своем потоке
+    S11Parser::ParseOptions parseOptions;
+    if (jobs.size() >= static_cast<size_t>(options.jobs)) {
+        parseOptions.parallelThreshold = std::numeric_limits<size_t>::max();
+    }
+    
+    QThreadPool pool;
+    pool.setMaxThreadCount(options.jobs);
+    QtConcurrent::blockingMap(&pool, jobs, [&options, &parseOptions](RenderJob& job) {
+        renderOne(job, options, parseOptions);
+    });
+    
+    size_t failed = 0;
+    for (const RenderJob& job : jobs) {
+        if (job.status != S11Parser::ParseResult::Success) {
+            std::fprintf(stderr, "%s: %s\n", job.input.path.string().c_str(), BatchFiles::statusText(job.status));
+            ++failed;
+        } else if (!job.saved) {
+            std::fprintf(stderr, "%s: cannot write %s\n", job.input.path.string().c_str(),
+                         job.outputPath.string().c_str());
+            ++failed;
+        }
+    }
+    
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%zu images (%zu failed) in %.2f s, %.1f images/s, %dx%d@%gx, %d jobs\n",
+                 jobs.size() - failed, failed, seconds, static_cast<double>(jobs.size()) / seconds,
+                 options.size.width(), options.size.height(), options.devicePixelRatio, options.jobs);
+    
+    // Только в сборке с TOUCHSTONE_ENABLE_TRACING
+    PERF_WRITE_TRACE(std::getenv("TOUCHSTONE_TRACE_FILE") ? std::getenv("TOUCHSTONE_TRACE_FILE")
+                                                          : "touchstone-render-trace.json");
+    
+    return failed == 0 ? 0 : 3;
+}